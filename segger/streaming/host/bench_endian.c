@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * host benchmark of the little endian copy kernels. Every datatype with a fixed sample size is copied once
+ * with streaming_copy_samples_le and once with the per sample path the kernels replaced, the outputs are
+ * compared and the throughput of both is printed. Build with -DSTREAMING_BIG_ENDIAN=1 to measure
+ * the swapping kernels on a little endian host.
+ */
+
+#include "streaming_endian.h"
+#include "SEGGER_UTIL.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_BYTES (64 * 1024)
+#define BENCH_ROUNDS 2000
+
+static const char *datatype_names[] = {
+    "int8",      "uint8",      "int16",      "uint16",     "int32",      "uint32",    "int64",
+    "uint64",    "int128",     "uint128",    "real32",     "real64",     "complex32", "complex64",
+    "bitfield8", "bitfield16", "bitfield32", "bitfield64", "struct",
+};
+
+static double now_s(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#if STREAMING_BIG_ENDIAN
+	// on a little endian host the native words of a big endian target are the byte swapped loads
+	#define NATIVE16(v) streaming_bswap16(v)
+	#define NATIVE32(v) streaming_bswap32(v)
+	#define NATIVE64(v) streaming_bswap64(v)
+#else
+	#define NATIVE16(v) (v)
+	#define NATIVE32(v) (v)
+	#define NATIVE64(v) (v)
+#endif
+
+/**
+ * the per sample path the kernels replaced: a switch on the datatype for every sample and a SEGGER_WrUxxLE of
+ * each native word. The bitfield words, added later, are written like unsigned integers of their width.
+ */
+static inline void copy_sample_reference(signal_data_type_e datatype, unsigned char *dst, const void *src)
+{
+	switch (datatype) {
+	case signal_type_int8:
+	case signal_type_uint8:
+	case signal_type_bitfield8:
+		*dst = *(const U8 *)src;
+		break;
+	case signal_type_int16:
+	case signal_type_uint16:
+	case signal_type_bitfield16:
+		SEGGER_WrU16LE(dst, NATIVE16(*(const U16 *)src));
+		break;
+	case signal_type_int32:
+	case signal_type_uint32:
+	case signal_type_real32:
+	case signal_type_bitfield32:
+		SEGGER_WrU32LE(dst, NATIVE32(*(const U32 *)src));
+		break;
+	case signal_type_int64:
+	case signal_type_uint64:
+	case signal_type_real64:
+	case signal_type_bitfield64:
+		SEGGER_WrU64LE(dst, NATIVE64(*(const U64 *)src));
+		break;
+	case signal_type_complex32: {
+		const U32 *ptr32 = (const U32 *)src;
+		SEGGER_WrU32LE(dst, NATIVE32(ptr32[0]));
+		SEGGER_WrU32LE(dst + sizeof(U32), NATIVE32(ptr32[1]));
+		break;
+	}
+	case signal_type_complex64: {
+		const U64 *ptr64 = (const U64 *)src;
+		SEGGER_WrU64LE(dst, NATIVE64(ptr64[0]));
+		SEGGER_WrU64LE(dst + sizeof(U64), NATIVE64(ptr64[1]));
+		break;
+	}
+	case signal_type_int128:
+	case signal_type_uint128: {
+		// the old path left 128 bit samples out, they are written as one 128 bit word here
+		const U64 *ptr64 = (const U64 *)src;
+#if STREAMING_BIG_ENDIAN
+		SEGGER_WrU64LE(dst, NATIVE64(ptr64[1]));
+		SEGGER_WrU64LE(dst + sizeof(U64), NATIVE64(ptr64[0]));
+#else
+		SEGGER_WrU64LE(dst, ptr64[0]);
+		SEGGER_WrU64LE(dst + sizeof(U64), ptr64[1]);
+#endif
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void copy_reference(signal_data_type_e datatype, unsigned char *dst, const unsigned char *src, size_t num)
+{
+	size_t sample_size = openDAQ_get_sample_size(datatype);
+
+	for (size_t i = 0; i < num; i++, src += sample_size, dst += sample_size) {
+		copy_sample_reference(datatype, dst, src);
+	}
+}
+
+int main(void)
+{
+	unsigned char *src = malloc(BENCH_BYTES);
+	unsigned char *dst = malloc(BENCH_BYTES);
+	unsigned char *ref = malloc(BENCH_BYTES);
+	int failed = 0;
+
+	if (src == NULL || dst == NULL || ref == NULL) {
+		return 1;
+	}
+	for (size_t i = 0; i < BENCH_BYTES; i++) {
+		src[i] = (unsigned char)(i * 131 + 7);
+	}
+
+	printf("%-11s %12s %12s %8s\n", "datatype", "kernel MB/s", "sample MB/s", "speedup");
+	for (int t = signal_type_int8; t <= signal_type_struct; t++) {
+		signal_data_type_e datatype = t;
+		size_t sample_size = openDAQ_get_sample_size(datatype);
+
+		if (sample_size == 0) {
+			// records are described by their struct object, see streaming_struct.h
+			printf("%-11s %12s\n", datatype_names[t], "skipped");
+			continue;
+		}
+
+		size_t num = BENCH_BYTES / sample_size;
+		double start = now_s();
+		for (int r = 0; r < BENCH_ROUNDS; r++) {
+			streaming_copy_samples_le(datatype, dst, src, num);
+			__asm__ volatile("" : : "r"(dst) : "memory");
+		}
+		double kernel = now_s() - start;
+
+		start = now_s();
+		for (int r = 0; r < BENCH_ROUNDS; r++) {
+			copy_reference(datatype, ref, src, num);
+			__asm__ volatile("" : : "r"(ref) : "memory");
+		}
+		double reference = now_s() - start;
+
+		if (memcmp(dst, ref, num * sample_size)) {
+			printf("%-11s output differs from the reference\n", datatype_names[t]);
+			failed = 1;
+			continue;
+		}
+
+		double mb = (double)BENCH_BYTES * BENCH_ROUNDS / 1e6;
+		printf("%-11s %12.0f %12.0f %7.1fx\n", datatype_names[t], mb / kernel, mb / reference, reference / kernel);
+	}
+
+	free(src);
+	free(dst);
+	free(ref);
+	return failed;
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * host benchmark of the pipeline. Blocks of a quantized real signal are serialized and sent to a simulated
+ * network stack, which sleeps for a fixed time per byte like a blocking send. A single task serializing into a
+ * buffer and sending it when full is compared to the pipeline, written through pipeline->stream and serialized in
+ * place. The bytes arriving at the stack are checked against the single task first.
+ */
+
+#include "stream_host.h"
+#include "streaming_packet.h"
+#include "streaming_pipeline.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/prctl.h>
+#include <time.h>
+
+#define BENCH_BUFFER_SIZE 8192
+#define BENCH_SAMPLES 512
+#define BENCH_BLOCKS 20000
+
+// the benchmark has a single signal and no meta information, see streaming_signals.c and streaming_meta.c
+unsigned int signal_get_signal_no(signal_t *signal)
+{
+	(void)signal;
+	return 1;
+}
+
+bool signal_has_subscription(signal_t *signal)
+{
+	return signal->stream != NULL;
+}
+
+int streaming_send_meta_signal(const struct stream *stream, signal_t *signal, uint64_t valueIndex)
+{
+	(void)stream;
+	(void)signal;
+	(void)valueIndex;
+	return 0;
+}
+
+int streaming_send_fill_level(const struct stream *stream, uint8_t fill_level)
+{
+	(void)stream;
+	(void)fill_level;
+	return 0;
+}
+
+void signal_table_domain_changed(signal_table_t *table)
+{
+	(void)table;
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static range_object_t range = {.low = -10, .high = 10};
+static quantization_object_t quantization = {.datatype = signal_type_int16};
+static signal_definition_t definition = {.name = "ai",
+                                         .rule = signal_explicit_rule,
+                                         .datatype = signal_type_real64,
+                                         .range = &range,
+                                         .quantization = &quantization};
+static signal_t signal = {.definition = &definition};
+static double samples[BENCH_SAMPLES];
+
+// the simulated network stack
+static double stack_ns_per_byte;
+static unsigned long long stack_bytes;
+static unsigned char stack_sum;
+
+static int stack_send(const struct stream *s, const char *buf, size_t len)
+{
+	(void)s;
+	for (size_t i = 0; i < len; i++) {
+		stack_sum += buf[i];
+	}
+	if (stack_ns_per_byte > 0) {
+		struct timespec wait = {0, (long)(len * stack_ns_per_byte)};
+		nanosleep(&wait, NULL);
+	}
+	stack_bytes += len;
+	return (int)len;
+}
+
+static void *transmit_task(void *pipeline)
+{
+	streaming_pipeline_run(pipeline);
+	return NULL;
+}
+
+/**
+ * serializes blocks into a buffer of the size of one pipeline buffer and sends it whenever the next block does
+ * not fit, all in the calling task
+ */
+static void produce_single(const struct stream *stream, unsigned int blocks)
+{
+	static unsigned char buffer[BENCH_BUFFER_SIZE];
+	size_t fill = 0;
+
+	signal.stream = stream;
+	for (unsigned int i = 0; i < blocks; i++) {
+		if (fill + openDAQ_streaming_explicit_size(&signal, BENCH_SAMPLES) > sizeof(buffer)) {
+			stream->stream(stream, (const char *)buffer, fill);
+			fill = 0;
+		}
+		fill += openDAQ_streaming_serialize_explicit_signal(buffer + fill, sizeof(buffer) - fill, &signal, samples,
+		                                                    BENCH_SAMPLES);
+	}
+	if (fill > 0) {
+		stream->stream(stream, (const char *)buffer, fill);
+	}
+}
+
+static int produce_piped(pipeline_t *pipeline, unsigned int blocks)
+{
+	signal.stream = &pipeline->stream;
+	for (unsigned int i = 0; i < blocks; i++) {
+		if (openDAQ_streaming_send_explicit_signal(&pipeline->stream, &signal, samples, BENCH_SAMPLES) < 0) {
+			return -1;
+		}
+	}
+	return streaming_pipeline_flush(pipeline);
+}
+
+static int produce_in_place(pipeline_t *pipeline, unsigned int blocks)
+{
+	size_t size = openDAQ_streaming_explicit_size(&signal, BENCH_SAMPLES);
+
+	signal.stream = &pipeline->stream;
+	for (unsigned int i = 0; i < blocks; i++) {
+		unsigned char *dst = streaming_pipeline_reserve(pipeline, size);
+		if (dst == NULL) {
+			return -1;
+		}
+		streaming_pipeline_commit(
+		    pipeline, openDAQ_streaming_serialize_explicit_signal(dst, size, &signal, samples, BENCH_SAMPLES));
+	}
+	return streaming_pipeline_flush(pipeline);
+}
+
+int main(int argc, char **argv)
+{
+	static unsigned char memory[2 * BENCH_BUFFER_SIZE];
+	static const double costs[] = {1, 2, 3, 5, 10};
+	unsigned int blocks = argc > 1 ? (unsigned int)atoi(argv[1]) : BENCH_BLOCKS;
+	struct stream stack;
+	pipeline_t pipeline;
+	pthread_t transmit;
+	int failed = 0;
+
+	// short sleeps of the simulated stack would be stretched by the default timer slack of 50 us
+	prctl(PR_SET_TIMERSLACK, 1);
+	for (unsigned int i = 0; i < BENCH_SAMPLES; i++) {
+		samples[i] = 9.0 * sin(i * 0.01);
+	}
+	stream_host_init(&stack, stack_send, "bench");
+	if (streaming_pipeline_init(&pipeline, &stack, memory, sizeof(memory)) < 0) {
+		return 1;
+	}
+	pthread_create(&transmit, NULL, transmit_task, &pipeline);
+
+	// all three ways deliver the same bytes
+	produce_single(&stack, 100);
+	unsigned long long bytes = stack_bytes;
+	unsigned char sum = stack_sum;
+	stack_bytes = stack_sum = 0;
+	if (produce_piped(&pipeline, 100) < 0 || stack_bytes != bytes || stack_sum != sum) {
+		printf("pipelined bytes differ\n");
+		failed = 1;
+	}
+	stack_bytes = stack_sum = 0;
+	if (produce_in_place(&pipeline, 100) < 0 || stack_bytes != bytes || stack_sum != sum) {
+		printf("bytes serialized in place differ\n");
+		failed = 1;
+	}
+
+	printf("%8s %10s %10s %8s %10s %8s %8s %8s\n", "ns/byte", "single", "pipelined", "speedup", "in place",
+	       "speedup", "swaps", "stalls");
+	for (unsigned int k = 0; k < sizeof(costs) / sizeof(costs[0]); k++) {
+		stack_ns_per_byte = costs[k];
+
+		stack_bytes = 0;
+		double start = now_s();
+		produce_single(&stack, blocks);
+		double single = now_s() - start;
+		bytes = stack_bytes;
+
+		stack_bytes = 0;
+		pipeline.swaps = pipeline.stalls = 0;
+		start = now_s();
+		failed |= produce_piped(&pipeline, blocks) < 0 || stack_bytes != bytes;
+		double piped = now_s() - start;
+		uint32_t swaps = pipeline.swaps;
+		uint32_t stalls = pipeline.stalls;
+
+		stack_bytes = 0;
+		start = now_s();
+		failed |= produce_in_place(&pipeline, blocks) < 0 || stack_bytes != bytes;
+		double in_place = now_s() - start;
+
+		// throughput in MB/s
+		printf("%8.1f %10.1f %10.1f %8.2f %10.1f %8.2f %8u %8u\n", costs[k], bytes / single / 1e6,
+		       bytes / piped / 1e6, single / piped, bytes / in_place / 1e6, single / in_place, swaps, stalls);
+	}
+
+	streaming_pipeline_stop(&pipeline);
+	pthread_join(transmit, NULL);
+	return failed;
+}
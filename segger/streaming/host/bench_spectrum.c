@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * host benchmark of the spectrum. The FFT kernel is checked against a direct DFT and timed for several sizes,
+ * then the complete processing of a block, i.e. window, real FFT, power and serialization, is timed for a
+ * spectrum signal of the same size.
+ */
+
+#include "streaming_packet.h"
+#include "streaming_spectrum.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SIZE_MAX 4096
+#define BENCH_SECONDS 0.2
+
+// the benchmark has a single table and no meta information, see streaming_signals.c and streaming_meta.c
+unsigned int signal_get_signal_no(signal_t *signal)
+{
+	(void)signal;
+	return 1;
+}
+
+bool signal_has_subscription(signal_t *signal)
+{
+	return signal->stream != NULL;
+}
+
+int streaming_send_meta_signal(const struct stream *stream, signal_t *signal, uint64_t valueIndex)
+{
+	(void)stream;
+	(void)signal;
+	(void)valueIndex;
+	return 0;
+}
+
+int streaming_send_fill_level(const struct stream *stream, uint8_t fill_level)
+{
+	(void)stream;
+	(void)fill_level;
+	return 0;
+}
+
+void signal_table_domain_changed(signal_table_t *table)
+{
+	(void)table;
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * largest deviation of the FFT of n complex values from the direct DFT, relative to the largest bin
+ */
+static double fft_error(const float *in, const float *out, uint32_t n)
+{
+	double max_error = 0;
+	double max_bin = 0;
+
+	for (uint32_t k = 0; k < n; k++) {
+		double re = 0;
+		double im = 0;
+		for (uint32_t j = 0; j < n; j++) {
+			double a = -2 * M_PI * (double)j * k / n;
+			re += in[2 * j] * cos(a) - in[2 * j + 1] * sin(a);
+			im += in[2 * j] * sin(a) + in[2 * j + 1] * cos(a);
+		}
+		double error = hypot(re - out[2 * k], im - out[2 * k + 1]);
+		max_error = error > max_error ? error : max_error;
+		max_bin = hypot(re, im) > max_bin ? hypot(re, im) : max_bin;
+	}
+	return max_error / max_bin;
+}
+
+/**
+ * @return time in microseconds of one FFT of n complex values
+ */
+static double bench_fft(float *data, const float *in, uint32_t n, const float *twiddle)
+{
+	unsigned int rounds = 0;
+	double start = now_s();
+	double elapsed;
+
+	do {
+		for (unsigned int r = 0; r < 100; r++) {
+			memcpy(data, in, 2 * n * sizeof(float));
+			spectrum_fft(data, n, twiddle, 1);
+			__asm__ volatile("" : : "r"(data) : "memory");
+		}
+		rounds += 100;
+		elapsed = now_s() - start;
+	} while (elapsed < BENCH_SECONDS);
+
+	// the copy of the input is part of the measurement, it is small compared to the transform
+	return elapsed * 1e6 / rounds;
+}
+
+/**
+ * @return time in microseconds to process one block of size int16 samples into a serialized spectrum
+ */
+static double bench_process(uint32_t size, const int16_t *src, unsigned char *dst, size_t dst_size, float *work)
+{
+	spectrum_object_t object = {.size = size, .sampleRate = 48000, .averages = 1};
+	signal_definition_t defs[2] = {
+	    {.name = "frequency", .rule = signal_linear_rule, .datatype = signal_type_real64,
+	     .signaltype = signal_type_time},
+	    {.name = "spectrum", .rule = signal_explicit_rule, .datatype = signal_type_real32, .spectrum = &object},
+	};
+	signal_t signals[2] = {{.definition = &defs[0]}, {.definition = &defs[1]}};
+	signal_table_t table = {.signal_counter = 2, .signals = signals, .domain_factor = 1};
+	struct stream stream = {0};
+	spectrum_t spectrum;
+
+	for (int i = 0; i < 2; i++) {
+		signals[i].table = &table;
+		// any stream counts as subscription, nothing is sent
+		signals[i].stream = &stream;
+	}
+	if (streaming_spectrum_add(&spectrum, &signals[1], signal_type_int16, work, SPECTRUM_WORK_SIZE(size)) < 0) {
+		return -1;
+	}
+
+	unsigned int rounds = 0;
+	double start = now_s();
+	double elapsed;
+	do {
+		for (unsigned int r = 0; r < 10; r++) {
+			if (streaming_spectrum_process(&spectrum, dst, dst_size, src, size) <= 0) {
+				return -1;
+			}
+		}
+		rounds += 10;
+		elapsed = now_s() - start;
+	} while (elapsed < BENCH_SECONDS);
+	return elapsed * 1e6 / rounds;
+}
+
+int main(void)
+{
+	float *in = malloc(2 * BENCH_SIZE_MAX * sizeof(float));
+	float *data = malloc(2 * BENCH_SIZE_MAX * sizeof(float));
+	float *twiddle = malloc(BENCH_SIZE_MAX * sizeof(float));
+	float *work = malloc(SPECTRUM_WORK_SIZE(BENCH_SIZE_MAX));
+	int16_t *src = malloc(BENCH_SIZE_MAX * sizeof(int16_t));
+	size_t dst_size = STREAMING_HEADER_SIZE_MAX * 2 + sizeof(uint64_t) * 2 + (BENCH_SIZE_MAX / 2 + 1) * sizeof(float);
+	unsigned char *dst = malloc(dst_size);
+	int failed = 0;
+
+	if (in == NULL || data == NULL || twiddle == NULL || work == NULL || src == NULL || dst == NULL) {
+		return 1;
+	}
+	srand(1);
+	for (uint32_t i = 0; i < 2 * BENCH_SIZE_MAX; i++) {
+		in[i] = rand() / (float)RAND_MAX - 0.5f;
+	}
+	for (uint32_t i = 0; i < BENCH_SIZE_MAX; i++) {
+		src[i] = (int16_t)(8000 * sin(2 * M_PI * 1000 * i / 48000.0) + rand() % 100);
+	}
+
+	printf("%8s %10s %12s %8s %12s\n", "complex", "fft us", "rel. error", "block", "process us");
+	// n complex values, the processed real blocks have 2 n samples
+	for (uint32_t n = 16; 2 * n <= BENCH_SIZE_MAX; n <<= 1) {
+		for (uint32_t k = 0; k < n / 2; k++) {
+			twiddle[2 * k] = (float)cos(2 * M_PI * k / n);
+			twiddle[2 * k + 1] = (float)-sin(2 * M_PI * k / n);
+		}
+		memcpy(data, in, 2 * n * sizeof(float));
+		spectrum_fft(data, n, twiddle, 1);
+		double error = fft_error(in, data, n);
+		if (error > 1e-5) {
+			failed = 1;
+		}
+
+		// a real block of 2 n samples is transformed as n complex values
+		double process = bench_process(2 * n, src, dst, dst_size, work);
+		if (process < 0) {
+			printf("%6u processing failed\n", 2 * n);
+			failed = 1;
+			continue;
+		}
+		printf("%8u %10.2f %12.1e %8u %12.2f\n", n, bench_fft(data, in, n, twiddle), error, 2 * n, process);
+	}
+
+	free(in);
+	free(data);
+	free(twiddle);
+	free(work);
+	free(src);
+	free(dst);
+	return failed;
+}
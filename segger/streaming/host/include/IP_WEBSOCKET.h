@@ -0,0 +1,15 @@
+#ifndef _HOST_IP_WEBSOCKET_H_
+#define _HOST_IP_WEBSOCKET_H_
+
+/**
+ * host stand-in for the emNet websocket definitions the streaming module uses
+ */
+
+#define IP_WEBSOCKET_FRAME_TYPE_CONTINUE 0
+#define IP_WEBSOCKET_FRAME_TYPE_TEXT 1
+#define IP_WEBSOCKET_FRAME_TYPE_BINARY 2
+#define IP_WEBSOCKET_FRAME_TYPE_CLOSE 8
+#define IP_WEBSOCKET_FRAME_TYPE_PING 9
+#define IP_WEBSOCKET_FRAME_TYPE_PONG 10
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef _HOST_SEGGER_UTIL_H_
+#define _HOST_SEGGER_UTIL_H_
+
+/**
+ * host stand-in for the few SEGGER utility functions the streaming module uses
+ */
+
+#include <stdint.h>
+
+typedef uint8_t U8;
+typedef uint16_t U16;
+typedef uint32_t U32;
+typedef uint64_t U64;
+typedef int32_t I32;
+
+static inline void SEGGER_WrU16LE(U8 *p, U16 v)
+{
+	p[0] = (U8)v;
+	p[1] = (U8)(v >> 8);
+}
+
+static inline void SEGGER_WrU32LE(U8 *p, U32 v)
+{
+	for (int i = 0; i < 4; i++) {
+		p[i] = (U8)(v >> (8 * i));
+	}
+}
+
+static inline void SEGGER_WrU64LE(U8 *p, U64 v)
+{
+	for (int i = 0; i < 8; i++) {
+		p[i] = (U8)(v >> (8 * i));
+	}
+}
+
+static inline U32 SEGGER_RdU32LE(const U8 *p)
+{
+	return (U32)p[0] | ((U32)p[1] << 8) | ((U32)p[2] << 16) | ((U32)p[3] << 24);
+}
+
+#endif
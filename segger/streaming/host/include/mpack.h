@@ -0,0 +1,8 @@
+#ifndef _HOST_MPACK_H_
+#define _HOST_MPACK_H_
+
+/**
+ * host stand-in for mpack. The host programs do not build the meta information, which is the only user of mpack.
+ */
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * host test of the websocket length header. Explicit uint8 signals are serialized with websocket payloads at the
+ * limits of the 7 bit, 16 bit and 64 bit length encodings, the headers are checked byte by byte and parsed again.
+ */
+
+#include "streaming_packet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the test has a single signal and no meta information, see streaming_signals.c and streaming_meta.c
+unsigned int signal_get_signal_no(signal_t *signal)
+{
+	(void)signal;
+	return 1;
+}
+
+bool signal_has_subscription(signal_t *signal)
+{
+	return signal->stream != NULL;
+}
+
+int streaming_send_meta_signal(const struct stream *stream, signal_t *signal, uint64_t valueIndex)
+{
+	(void)stream;
+	(void)signal;
+	(void)valueIndex;
+	return 0;
+}
+
+int streaming_send_fill_level(const struct stream *stream, uint8_t fill_level)
+{
+	(void)stream;
+	(void)fill_level;
+	return 0;
+}
+
+void signal_table_domain_changed(signal_table_t *table)
+{
+	(void)table;
+}
+
+static int check(signal_t *signal, unsigned char *buf, size_t buf_size, size_t websocket_payload,
+                 size_t websocket_header)
+{
+	// transport layer header of 4 bytes for payloads of up to 255 bytes, 8 bytes above
+	size_t num = websocket_payload - (websocket_payload - 4 > 255 ? 8 : 4);
+	int ret = openDAQ_streaming_serialize_explicit_signal(buf, buf_size, signal, buf + buf_size / 2, num);
+	size_t expected = websocket_header + websocket_payload;
+	uint64_t length = 0;
+
+	if (ret != (int)expected || openDAQ_streaming_explicit_size(signal, num) != expected) {
+		printf("payload %zu: %d bytes written, %zu expected\n", websocket_payload, ret, expected);
+		return 1;
+	}
+
+	if (websocket_header == 2) {
+		length = buf[1];
+	} else if (websocket_header == 4 && buf[1] == 126) {
+		length = ((uint64_t)buf[2] << 8) | buf[3];
+	} else if (websocket_header == 10 && buf[1] == 127) {
+		for (int i = 2; i < 10; i++) {
+			length = (length << 8) | buf[i];
+		}
+	}
+	if (buf[0] != 0x82 || length != websocket_payload) {
+		printf("payload %zu: wrong websocket header %02x %02x\n", websocket_payload, buf[0], buf[1]);
+		return 1;
+	}
+
+	streaming_packet_info_t info;
+	if (!openDAQ_streaming_parse_header(buf, ret, &info) || info.length != expected ||
+	    info.packet_type != TYPE_DATA || info.signal_number != 1) {
+		printf("payload %zu: parsed header differs\n", websocket_payload);
+		return 1;
+	}
+
+	printf("payload %6zu: %2zu byte header ok\n", websocket_payload, websocket_header);
+	return 0;
+}
+
+int main(void)
+{
+	// the samples are taken from the second half of the buffer, the packet is written to the first half
+	size_t buf_size = 2 * 70000;
+	unsigned char *buf = malloc(buf_size);
+	signal_definition_t def = {
+	    .name = "waveform",
+	    .rule = signal_explicit_rule,
+	    .datatype = signal_type_uint8,
+	    .signaltype = signal_type_value,
+	};
+	signal_t signal = {.definition = &def};
+	int failed = 0;
+
+	if (buf == NULL) {
+		return 1;
+	}
+	memset(buf, 0x5a, buf_size);
+
+	failed |= check(&signal, buf, buf_size, 125, 2);
+	failed |= check(&signal, buf, buf_size, 126, 4);
+	failed |= check(&signal, buf, buf_size, 65535, 4);
+	failed |= check(&signal, buf, buf_size, 65536, 10);
+
+	free(buf);
+	return failed;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "stream_id.h"
+#include "streaming_config.h"
+#include <string.h>
+
+int stream_gather_segments(const struct stream *s, const stream_segment_t *segments, unsigned int num)
+{
+	char gather[STREAMING_TX_GATHER_SIZE];
+	size_t used = 0;
+	int total = 0;
+
+	for (unsigned int i = 0; i < num; i++) {
+		const char *buf = segments[i].pBuffer;
+		size_t len = segments[i].NumBytes;
+		size_t n = len < sizeof(gather) - used ? len : sizeof(gather) - used;
+
+		memcpy(gather + used, buf, n);
+		used += n;
+		if (n == len) {
+			continue;
+		}
+
+		// gather buffer full
+		int ret = s->stream(s, gather, used);
+		if (ret < 0) {
+			return ret;
+		}
+		total += ret;
+		buf += n;
+		len -= n;
+		used = 0;
+
+		if (len < sizeof(gather)) {
+			memcpy(gather, buf, len);
+			used = len;
+			continue;
+		}
+		ret = s->stream(s, buf, len);
+		if (ret < 0) {
+			return ret;
+		}
+		total += ret;
+	}
+
+	if (used > 0) {
+		int ret = s->stream(s, gather, used);
+		if (ret < 0) {
+			return ret;
+		}
+		total += ret;
+	}
+	return total;
+}
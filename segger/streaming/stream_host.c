@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stream_host.h"
+#include <stdlib.h>
+
+// stand-in for an emNet packet
+typedef struct {
+	size_t len;
+	unsigned char data[];
+} host_packet_t;
+
+static void *host_alloc_packet(const struct stream *s, size_t size, unsigned char **data)
+{
+	(void)s;
+	host_packet_t *p = malloc(sizeof(*p) + size);
+	if (p == NULL) {
+		return NULL;
+	}
+	p->len = size;
+	*data = p->data;
+	return p;
+}
+
+static void host_shrink_packet(const struct stream *s, void *p, size_t size)
+{
+	(void)s;
+	host_packet_t *packet = p;
+	if (size < packet->len) {
+		packet->len = size;
+	}
+}
+
+static void host_free_packet(const struct stream *s, void *p)
+{
+	(void)s;
+	free(p);
+}
+
+static int host_send_packet(const struct stream *s, void *p)
+{
+	host_packet_t *packet = p;
+	int ret = s->stream(s, (const char *)packet->data, packet->len);
+	free(packet);
+	return ret < 0 ? ret : 0;
+}
+
+void stream_host_init(struct stream *s, stream_send *sink, const char *id)
+{
+	s->stream = sink;
+	s->streamp = host_send_packet;
+	s->streamv = stream_gather_segments;
+	s->palloc = host_alloc_packet;
+	s->pshrink = host_shrink_packet;
+	s->pfree = host_free_packet;
+	s->backlog = NULL;
+	s->congestion = NULL;
+	s->lock = NULL;
+	s->downstream = NULL;
+	s->socket_handle = 0;
+	s->id = id;
+}
@@ -0,0 +1,16 @@
+#ifndef _STREAM_HOST_H_
+#define _STREAM_HOST_H_
+
+#include "stream_id.h"
+
+/**
+ * sets up a stream for host builds without emNet. All data, including zero-copy packets, ends up in sink.
+ * Packets are allocated from the heap and freed after they have been passed to the sink.
+ *
+ * @param s the stream to set up
+ * @param sink called for every block of data sent through the stream
+ * @param id stream id
+ */
+void stream_host_init(struct stream *s, stream_send *sink, const char *id);
+
+#endif
@@ -16,8 +16,13 @@
 
 #include "stream_id.h"
 #include "IP.h"
+#include "streaming_config.h"
+#include "streaming_congestion.h"
+#include "streaming_os.h"
 
 struct stream single_stream;
+static stream_congestion_t single_stream_congestion;
+static struct stream_lock single_stream_lock;
 
 static int socket_send(const struct stream *s, const char *buf, size_t len)
 {
@@ -29,6 +34,30 @@ static int socket_send_packet(const struct stream *s, void *p)
 	return IP_TCP_SendAndFree(s->socket_handle, (IP_PACKET *)p);
 }
 
+static void *socket_alloc_packet(const struct stream *s, size_t size, unsigned char **data)
+{
+	(void)s;
+	IP_PACKET *p = IP_TCP_Alloc(size);
+	if (p == NULL) {
+		return NULL;
+	}
+	*data = p->pData;
+	return p;
+}
+
+static void socket_shrink_packet(const struct stream *s, void *p, size_t size)
+{
+	(void)s;
+	// works for TCP packets as well
+	IP_UDP_ReducePayloadLen((IP_PACKET *)p, size);
+}
+
+static void socket_free_packet(const struct stream *s, void *p)
+{
+	(void)s;
+	IP_TCP_Free((IP_PACKET *)p);
+}
+
 void stream_free(struct stream *s)
 {
 	// socket handle closed elsewhere
@@ -40,6 +69,15 @@ struct stream *stream_malloc(int socket, const char *id)
 	single_stream.socket_handle = socket;
 	single_stream.stream = socket_send;
 	single_stream.streamp = socket_send_packet;
+	single_stream.streamv = stream_gather_segments;
+	single_stream.palloc = socket_alloc_packet;
+	single_stream.pshrink = socket_shrink_packet;
+	single_stream.pfree = socket_free_packet;
+	single_stream.backlog = NULL;
+	single_stream.lock = &single_stream_lock;
+	single_stream.downstream = NULL;
+	streaming_congestion_init(&single_stream, &single_stream_congestion, STREAMING_CONGESTION_BYTES,
+	                          STREAMING_CONGESTION_PACKETS);
 	single_stream.id = id;
 	return &single_stream;
 }
@@ -49,4 +87,5 @@ void streaming_streams_init(void)
 	for (int i = 0; i < NUM_STREAMS_MAX; i++) {
 		single_stream.socket_handle = 0;
 	}
+	streaming_mutex_init(&single_stream_lock.mutex);
 }
\ No newline at end of file
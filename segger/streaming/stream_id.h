@@ -6,16 +6,59 @@
 #define NUM_STREAMS_MAX 1
 
 extern struct stream single_stream;
+
+// one segment of a scatter-gather send, the memory is referenced, not copied
+typedef struct {
+	const char *pBuffer;
+	size_t NumBytes;
+} stream_segment_t;
+
 typedef int stream_send(const struct stream *s, const char *pBuffer, size_t NumBytes);
 typedef int stream_send_packet(const struct stream *s, void *p);
+typedef int stream_send_segments(const struct stream *s, const stream_segment_t *segments, unsigned int num);
+
+// zero-copy packets for streamp, data returns the pointer to the payload area of the packet
+typedef void *stream_alloc_packet(const struct stream *s, size_t size, unsigned char **data);
+typedef void stream_shrink_packet(const struct stream *s, void *p, size_t size);
+typedef void stream_free_packet(const struct stream *s, void *p);
+// number of bytes queued in front of the network, e.g. in a coalescer, <0 if unknown
+typedef int stream_backlog(const struct stream *s);
+
+// congestion state of a stream, see streaming_congestion.h
+struct stream_congestion;
+
+// keeps the packets of several sending tasks apart, see streaming_os.h
+struct stream_lock;
 
 struct stream {
 	stream_send *stream;
 	stream_send_packet *streamp;
+	stream_send_segments *streamv;
+	stream_alloc_packet *palloc;
+	stream_shrink_packet *pshrink;
+	stream_free_packet *pfree;
+	// optional, may be NULL
+	stream_backlog *backlog;
+	// optional, NULL disables congestion tracking
+	struct stream_congestion *congestion;
+	// optional, NULL if only one task sends through the stream
+	struct stream_lock *lock;
+	// streams in front of another stream only, the stream they write to, see stream_passthrough.h
+	const struct stream *downstream;
 	int socket_handle;
 	const char *id;
 };
 
+/**
+ * sends the segments through s->stream with as few calls as possible. Without Nagle's algorithm every send()
+ * leaves as a TCP segment of its own, so small segments like packet headers are gathered on the stack together
+ * with the head of the following segment. The rest of a large segment is sent from its memory without being
+ * copied. Streams use it as their streamv.
+ *
+ * @return <0 error of s->stream, else the number of bytes sent
+ */
+int stream_gather_segments(const struct stream *s, const stream_segment_t *segments, unsigned int num);
+
 struct stream *stream_malloc(int socket, const char *id);
 void stream_free(struct stream *stream);
 void streaming_streams_init(void);
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "stream_passthrough.h"
+
+static int passthrough_send_segments(const struct stream *s, const stream_segment_t *segments, unsigned int num)
+{
+	int total = 0;
+	for (unsigned int i = 0; i < num; i++) {
+		if (segments[i].NumBytes == 0) {
+			continue;
+		}
+		int ret = s->stream(s, segments[i].pBuffer, segments[i].NumBytes);
+		if (ret < 0) {
+			return ret;
+		}
+		total += ret;
+	}
+	return total;
+}
+
+static void *passthrough_alloc_packet(const struct stream *s, size_t size, unsigned char **data)
+{
+	return s->downstream->palloc(s->downstream, size, data);
+}
+
+static void passthrough_shrink_packet(const struct stream *s, void *p, size_t size)
+{
+	s->downstream->pshrink(s->downstream, p, size);
+}
+
+static void passthrough_free_packet(const struct stream *s, void *p)
+{
+	s->downstream->pfree(s->downstream, p);
+}
+
+void stream_passthrough_init(struct stream *s, struct stream_lock *lock, const struct stream *downstream,
+                             stream_send *send, stream_send_packet *send_packet, stream_backlog *backlog)
+{
+	s->stream = send;
+	s->streamp = send_packet;
+	s->streamv = passthrough_send_segments;
+	s->palloc = passthrough_alloc_packet;
+	s->pshrink = passthrough_shrink_packet;
+	s->pfree = passthrough_free_packet;
+	s->backlog = backlog;
+	// the queued bytes count towards the congestion of the downstream stream
+	s->congestion = downstream->congestion;
+	s->lock = lock;
+	s->downstream = downstream;
+	s->socket_handle = downstream->socket_handle;
+	s->id = downstream->id;
+	streaming_mutex_init(&lock->mutex);
+}
+
+int stream_passthrough_backlog(const struct stream *s, size_t queued)
+{
+	int backlog = (int)queued;
+
+	if (s->downstream->backlog != NULL) {
+		int ret = s->downstream->backlog(s->downstream);
+		if (ret > 0) {
+			backlog += ret;
+		}
+	}
+	return backlog;
+}
+
+int stream_passthrough_write(const struct stream *s, const char *buf, size_t len)
+{
+	int ret = s->downstream->stream(s->downstream, buf, len);
+	return ret < 0 ? ret : 0;
+}
@@ -0,0 +1,45 @@
+#ifndef _STREAM_PASSTHROUGH_H_
+#define _STREAM_PASSTHROUGH_H_
+
+#include "stream_id.h"
+#include "streaming_os.h"
+#include <stddef.h>
+
+/**
+ * the parts streams in front of a downstream stream share, e.g. the coalescer, the scheduler, the pipeline and
+ * the periodic transmitter. Zero-copy packets are allocated downstream, segments are written one by one through
+ * the wrapping stream. The wrapping stream is the first member of its wrapper, so the callbacks of the wrapper
+ * cast s to the wrapper.
+ *
+ * Every wrapping stream has a lock of its own, which keeps the packets of several tasks writing through it apart.
+ */
+
+/**
+ * sets up s in front of downstream, sharing the congestion tracking of downstream
+ *
+ * @param s the wrapping stream
+ * @param lock lock of s, must stay valid as long as s
+ * @param downstream the stream the wrapper writes to
+ * @param send takes bytes into the wrapper
+ * @param send_packet passes a zero-copy packet downstream
+ * @param backlog bytes queued in the wrapper, usually via stream_passthrough_backlog
+ */
+void stream_passthrough_init(struct stream *s, struct stream_lock *lock, const struct stream *downstream,
+                             stream_send *send, stream_send_packet *send_packet, stream_backlog *backlog);
+
+/**
+ * backlog of a wrapping stream: the bytes queued in the wrapper plus the backlog of downstream. The wrappers
+ * read queued without taking their mutex, a slightly outdated value is good enough.
+ */
+int stream_passthrough_backlog(const struct stream *s, size_t queued);
+
+/**
+ * writes bytes queued in the wrapper downstream. The caller drops them on errors as well, the stream is broken
+ * anyway.
+ *
+ * @return <0 error of the downstream stream
+ *         0  success
+ */
+int stream_passthrough_write(const struct stream *s, const char *buf, size_t len);
+
+#endif
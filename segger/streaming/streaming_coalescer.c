@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "streaming_coalescer.h"
+#include "stream_passthrough.h"
+#include <string.h>
+
+static int flush_locked(coalescer_t *coalescer)
+{
+	if (coalescer->fill == 0) {
+		return 0;
+	}
+	int ret = stream_passthrough_write(&coalescer->stream, (const char *)coalescer->buffer, coalescer->fill);
+	coalescer->fill = 0;
+	return ret;
+}
+
+static int coalescer_send(const struct stream *s, const char *buf, size_t len)
+{
+	coalescer_t *coalescer = (coalescer_t *)s;
+	int ret = 0;
+
+	streaming_mutex_lock(&coalescer->mutex);
+	if (coalescer->error < 0) {
+		ret = coalescer->error;
+		coalescer->error = 0;
+		goto out;
+	}
+
+	if (coalescer->fill + len > coalescer->capacity || len >= coalescer->threshold) {
+		// keep the order of the bytes
+		ret = flush_locked(coalescer);
+		if (ret < 0) {
+			goto out;
+		}
+	}
+	if (len >= coalescer->threshold) {
+		ret = s->downstream->stream(s->downstream, buf, len);
+		goto out;
+	}
+
+	if (coalescer->fill == 0) {
+		// the deadline starts with the first byte, let the flush task know
+		coalescer->oldest_ms = streaming_os_time_ms();
+		streaming_wakeup_signal(&coalescer->wakeup);
+	}
+	memcpy(coalescer->buffer + coalescer->fill, buf, len);
+	coalescer->fill += len;
+	ret = (int)len;
+
+	if (coalescer->fill >= coalescer->threshold) {
+		coalescer->threshold_flushes++;
+		int err = flush_locked(coalescer);
+		if (err < 0) {
+			ret = err;
+		}
+	}
+
+out:
+	streaming_mutex_unlock(&coalescer->mutex);
+	return ret;
+}
+
+static int coalescer_send_packet(const struct stream *s, void *p)
+{
+	coalescer_t *coalescer = (coalescer_t *)s;
+	const struct stream *downstream = s->downstream;
+
+	streaming_mutex_lock(&coalescer->mutex);
+	int ret = flush_locked(coalescer);
+	if (ret < 0) {
+		downstream->pfree(downstream, p);
+	} else {
+		ret = downstream->streamp(downstream, p);
+	}
+	streaming_mutex_unlock(&coalescer->mutex);
+	return ret;
+}
+
+static int coalescer_backlog(const struct stream *s)
+{
+	return stream_passthrough_backlog(s, ((const coalescer_t *)s)->fill);
+}
+
+int streaming_coalescer_init(coalescer_t *coalescer, const struct stream *downstream, void *buffer, size_t buffer_size,
+                             size_t threshold, uint32_t deadline_ms)
+{
+	if (threshold == 0 || buffer_size < threshold) {
+		return -1;
+	}
+
+	stream_passthrough_init(&coalescer->stream, &coalescer->lock, downstream, coalescer_send, coalescer_send_packet,
+	                        coalescer_backlog);
+	coalescer->buffer = buffer;
+	coalescer->capacity = buffer_size;
+	coalescer->fill = 0;
+	coalescer->threshold = threshold;
+	coalescer->deadline_ms = deadline_ms;
+	coalescer->oldest_ms = 0;
+	coalescer->error = 0;
+	coalescer->running = true;
+	coalescer->threshold_flushes = 0;
+	coalescer->deadline_flushes = 0;
+	streaming_mutex_init(&coalescer->mutex);
+	streaming_wakeup_init(&coalescer->wakeup);
+	return 0;
+}
+
+int streaming_coalescer_flush(coalescer_t *coalescer)
+{
+	streaming_mutex_lock(&coalescer->mutex);
+	int ret = flush_locked(coalescer);
+	streaming_mutex_unlock(&coalescer->mutex);
+	return ret;
+}
+
+void streaming_coalescer_run(coalescer_t *coalescer)
+{
+	for (;;) {
+		uint32_t timeout = STREAMING_WAIT_FOREVER;
+
+		streaming_mutex_lock(&coalescer->mutex);
+		if (!coalescer->running) {
+			int ret = flush_locked(coalescer);
+			if (ret < 0) {
+				coalescer->error = ret;
+			}
+			streaming_mutex_unlock(&coalescer->mutex);
+			return;
+		}
+		if (coalescer->fill > 0) {
+			uint32_t waited = streaming_os_time_ms() - coalescer->oldest_ms;
+			if (waited >= coalescer->deadline_ms) {
+				coalescer->deadline_flushes++;
+				int ret = flush_locked(coalescer);
+				if (ret < 0) {
+					coalescer->error = ret;
+				}
+			} else {
+				timeout = coalescer->deadline_ms - waited;
+			}
+		}
+		streaming_mutex_unlock(&coalescer->mutex);
+
+		streaming_wakeup_wait(&coalescer->wakeup, timeout);
+	}
+}
+
+void streaming_coalescer_stop(coalescer_t *coalescer)
+{
+	streaming_mutex_lock(&coalescer->mutex);
+	coalescer->running = false;
+	streaming_mutex_unlock(&coalescer->mutex);
+	streaming_wakeup_signal(&coalescer->wakeup);
+}
@@ -0,0 +1,76 @@
+#ifndef _STREAMING_COALESCER_H_
+#define _STREAMING_COALESCER_H_
+
+#include "stream_id.h"
+#include "streaming_os.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * a coalescer sits in front of a stream and collects small packets into larger writes. It is a stream itself,
+ * everything serialized or sent through coalescer->stream ends up in its buffer. The buffer is written to the
+ * downstream stream when it holds threshold bytes (e.g. the TCP MSS) or when its oldest byte has waited
+ * deadline_ms, whichever comes first. The deadline is enforced by a flush task running
+ * streaming_coalescer_run.
+ *
+ * Zero-copy packets are not buffered, the buffer is flushed before they are passed downstream to keep the order.
+ */
+
+typedef struct {
+	// the coalescing stream, must be the first member
+	struct stream stream;
+	struct stream_lock lock;
+	unsigned char *buffer;
+	size_t capacity;
+	size_t fill;
+	size_t threshold;
+	uint32_t deadline_ms;
+	// time the oldest byte in the buffer was queued
+	uint32_t oldest_ms;
+	// error of a flush by the flush task, reported by the next send
+	int error;
+	bool running;
+	streaming_mutex_t mutex;
+	streaming_wakeup_t wakeup;
+	// statistics
+	uint32_t threshold_flushes;
+	uint32_t deadline_flushes;
+} coalescer_t;
+
+/**
+ * sets up a coalescer in front of downstream
+ *
+ * @param coalescer the coalescer to set up, must stay valid
+ * @param downstream the stream the coalesced data is written to
+ * @param buffer memory for the queued bytes
+ * @param buffer_size size in bytes of buffer, at least threshold
+ * @param threshold flush when this many bytes are queued, writes of at least threshold bytes bypass the buffer
+ * @param deadline_ms flush when the oldest queued byte has waited this long
+ *
+ * @return <0 error, e.g. buffer smaller than threshold
+ *         0  success
+ */
+int streaming_coalescer_init(coalescer_t *coalescer, const struct stream *downstream, void *buffer, size_t buffer_size,
+                             size_t threshold, uint32_t deadline_ms);
+
+/**
+ * writes all queued bytes downstream
+ *
+ * @return <0 error of the downstream stream
+ *         0  success
+ */
+int streaming_coalescer_flush(coalescer_t *coalescer);
+
+/**
+ * body of the flush task. Sleeps until the deadline of the oldest queued byte and flushes, returns after
+ * streaming_coalescer_stop.
+ */
+void streaming_coalescer_run(coalescer_t *coalescer);
+
+/**
+ * lets streaming_coalescer_run return after a final flush
+ */
+void streaming_coalescer_stop(coalescer_t *coalescer);
+
+#endif
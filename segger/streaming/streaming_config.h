@@ -41,8 +41,9 @@
 	#define JSONRPC_BUF_SIZE 256
 #endif
 
+// the signal meta information of a linear time signal alone takes about 250 bytes
 #ifndef MSGPACK_BUF_SIZE
-	#define MSGPACK_BUF_SIZE 256
+	#define MSGPACK_BUF_SIZE 512
 #endif
 
 #ifndef STREAMING_MAX_SIGNALS
@@ -53,6 +54,84 @@
 	#define STREAMING_MAX_TABLES 4
 #endif
 
+#ifndef STREAMING_MAX_TRIGGERS
+	#define STREAMING_MAX_TRIGGERS 4
+#endif
+
+// a stream is congested when this many bytes are queued or in flight in blocking sends
+#ifndef STREAMING_CONGESTION_BYTES
+	#define STREAMING_CONGESTION_BYTES 8192
+#endif
+
+// a stream is congested when this many zero-copy packets are queued by the network stack
+#ifndef STREAMING_CONGESTION_PACKETS
+	#define STREAMING_CONGESTION_PACKETS 4
+#endif
+
+// the stack does not report when a queued zero-copy packet left, one is counted as sent per this many milliseconds
+#ifndef STREAMING_CONGESTION_PACKET_DECAY_MS
+	#define STREAMING_CONGESTION_PACKET_DECAY_MS 10
+#endif
+
+// the fill level meta information is sent when the fill level changed by this many percent
+#ifndef STREAMING_FILLLEVEL_STEP
+	#define STREAMING_FILLLEVEL_STEP 10
+#endif
+
+// decimation factor of signals with policy congestion_decimate and no factor of their own
+#ifndef STREAMING_CONGESTION_DECIMATION
+	#define STREAMING_CONGESTION_DECIMATION 10
+#endif
+
+// gaps of a sample_ring_drop_newest ring waiting to be signalled, further overflows discard all samples meanwhile
+#ifndef STREAMING_SAMPLE_RING_GAPS
+	#define STREAMING_SAMPLE_RING_GAPS 4
+#endif
+
+// bytes per priority class the transmit scheduler can queue, see streaming_scheduler.h
+#ifndef STREAMING_SCHEDULER_QUEUE_SIZE
+	#define STREAMING_SCHEDULER_QUEUE_SIZE 2048
+#endif
+
+// packets per priority class the transmit scheduler can queue
+#ifndef STREAMING_SCHEDULER_QUEUE_PACKETS
+	#define STREAMING_SCHEDULER_QUEUE_PACKETS 32
+#endif
+
+// largest packet the transmit scheduler builds from a sample ring, the unit of preemption
+#ifndef STREAMING_SCHEDULER_PACKET_SIZE
+	#define STREAMING_SCHEDULER_PACKET_SIZE 1460
+#endif
+
+#ifndef STREAMING_SCHEDULER_MAX_RINGS
+	#define STREAMING_SCHEDULER_MAX_RINGS 8
+#endif
+
+// bytes a bulk source of weight 1 may send per round
+#ifndef STREAMING_SCHEDULER_QUANTUM
+	#define STREAMING_SCHEDULER_QUANTUM 1460
+#endif
+
+// the scheduler looks at the sample rings at least this often while idle
+#ifndef STREAMING_SCHEDULER_IDLE_MS
+	#define STREAMING_SCHEDULER_IDLE_MS 1
+#endif
+
+// maximum number of blocks of a transmit pool, see streaming_txpool.h
+#ifndef STREAMING_TXPOOL_BLOCKS
+	#define STREAMING_TXPOOL_BLOCKS 16
+#endif
+
+// bins of the lateness and jitter histograms of the periodic transmit mode, see streaming_periodic.h
+#ifndef STREAMING_PERIODIC_HISTOGRAM_BINS
+	#define STREAMING_PERIODIC_HISTOGRAM_BINS 16
+#endif
+
+// width in microseconds of one histogram bin
+#ifndef STREAMING_PERIODIC_BIN_US
+	#define STREAMING_PERIODIC_BIN_US 50
+#endif
+
 #ifndef STREAMING_SIGNAL_NAME_LENGTH
 	#define STREAMING_SIGNAL_NAME_LENGTH 32
 #endif
@@ -69,4 +148,28 @@
 	#define STREAMING_TCP_PORT 7412
 #endif
 
+// stack buffer in which small segments, e.g. packet headers, are gathered with the following data before send()
+#ifndef STREAMING_TX_GATHER_SIZE
+	#define STREAMING_TX_GATHER_SIZE 512
+#endif
+
+// stack buffer used to convert explicit samples on big endian targets while sending, a multiple of 8 of at least 24
+#ifndef STREAMING_TX_CHUNK_SIZE
+	#define STREAMING_TX_CHUNK_SIZE 64
+#endif
+
+// host builds run the timing and locking of the library on POSIX threads instead of embOS, see streaming_os.h
+#ifndef STREAMING_HOST_BUILD
+	#define STREAMING_HOST_BUILD 0
+#endif
+
+// byte order of the target, the wire format is always little endian
+#ifndef STREAMING_BIG_ENDIAN
+	#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		#define STREAMING_BIG_ENDIAN 1
+	#else
+		#define STREAMING_BIG_ENDIAN 0
+	#endif
+#endif
+
 #endif
\ No newline at end of file
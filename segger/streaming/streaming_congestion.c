@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "streaming_congestion.h"
+#include "streaming_config.h"
+#include "streaming_decimation.h"
+#include "streaming_handler.h"
+#include "streaming_os.h"
+#include "streaming_quantization.h"
+
+void streaming_congestion_init(struct stream *stream, stream_congestion_t *congestion, uint32_t limit_bytes,
+                               uint32_t limit_packets)
+{
+	congestion->limit_bytes = limit_bytes;
+	congestion->limit_packets = limit_packets;
+	atomic_init(&congestion->inflight_bytes, 0);
+	atomic_init(&congestion->queued_packets, 0);
+	atomic_init(&congestion->queued_ms, 0);
+	atomic_init(&congestion->fill_level, 0);
+	atomic_init(&congestion->reported_level, 0);
+	atomic_init(&congestion->congested, false);
+	atomic_flag_clear(&congestion->reporting);
+	atomic_init(&congestion->dropped, 0);
+	stream->congestion = congestion;
+}
+
+void streaming_congestion_begin(const struct stream *stream, size_t bytes)
+{
+	if (stream->congestion != NULL) {
+		atomic_fetch_add(&stream->congestion->inflight_bytes, (uint32_t)bytes);
+	}
+}
+
+void streaming_congestion_end(const struct stream *stream, size_t bytes)
+{
+	if (stream->congestion != NULL) {
+		atomic_fetch_sub(&stream->congestion->inflight_bytes, (uint32_t)bytes);
+		streaming_congestion_update(stream);
+	}
+}
+
+int streaming_congestion_packet_sent(const struct stream *stream, int ret)
+{
+	stream_congestion_t *congestion = stream->congestion;
+
+	if (congestion == NULL) {
+		return ret;
+	}
+	if (ret > 0) {
+		atomic_store(&congestion->queued_ms, streaming_os_time_ms());
+		atomic_fetch_add(&congestion->queued_packets, 1);
+	} else if (ret == 0) {
+		// sent right away, nothing is queued in front of this packet anymore
+		atomic_store(&congestion->queued_packets, 0);
+	}
+	streaming_congestion_update(stream);
+	return ret;
+}
+
+static uint32_t percent_of(uint32_t value, uint32_t limit)
+{
+	if (limit == 0) {
+		return 0;
+	}
+	uint64_t percent = (uint64_t)value * 100 / limit;
+	return percent > 100 ? 100 : (uint32_t)percent;
+}
+
+/**
+ * queued zero-copy packets, one is counted as sent per STREAMING_CONGESTION_PACKET_DECAY_MS since the count was
+ * last raised or decayed. A packet queued meanwhile wins over the decay.
+ */
+static uint32_t queued_packets(stream_congestion_t *congestion)
+{
+	uint32_t queued = atomic_load(&congestion->queued_packets);
+	uint32_t since = atomic_load(&congestion->queued_ms);
+	uint32_t decayed = (streaming_os_time_ms() - since) / STREAMING_CONGESTION_PACKET_DECAY_MS;
+
+	if (queued == 0 || decayed == 0) {
+		return queued;
+	}
+	uint32_t left = decayed < queued ? queued - decayed : 0;
+	if (!atomic_compare_exchange_strong(&congestion->queued_packets, &queued, left)) {
+		return queued;
+	}
+	uint32_t decayed_ms = since + decayed * STREAMING_CONGESTION_PACKET_DECAY_MS;
+	atomic_compare_exchange_strong(&congestion->queued_ms, &since, decayed_ms);
+	return left;
+}
+
+uint8_t streaming_congestion_recalculate(const struct stream *stream)
+{
+	stream_congestion_t *congestion = stream->congestion;
+
+	if (congestion == NULL) {
+		return 0;
+	}
+
+	uint32_t bytes = atomic_load(&congestion->inflight_bytes);
+	if (stream->backlog != NULL) {
+		int backlog = stream->backlog(stream);
+		if (backlog > 0) {
+			bytes += (uint32_t)backlog;
+		}
+	}
+	uint32_t level = percent_of(bytes, congestion->limit_bytes);
+	uint32_t level_packets = percent_of(queued_packets(congestion), congestion->limit_packets);
+	if (level_packets > level) {
+		level = level_packets;
+	}
+	atomic_store(&congestion->fill_level, level);
+
+	// hysteresis, so the policies do not toggle with every packet
+	if (level >= 100) {
+		atomic_store(&congestion->congested, true);
+	} else if (level <= 50) {
+		atomic_store(&congestion->congested, false);
+	}
+	return (uint8_t)level;
+}
+
+uint8_t streaming_congestion_update(const struct stream *stream)
+{
+	stream_congestion_t *congestion = stream->congestion;
+
+	if (congestion == NULL) {
+		return 0;
+	}
+
+	uint32_t level = streaming_congestion_recalculate(stream);
+	uint32_t reported = atomic_load(&congestion->reported_level);
+	bool changed = level >= reported + STREAMING_FILLLEVEL_STEP || level + STREAMING_FILLLEVEL_STEP <= reported ||
+	               (level != reported && (level == 0 || level == 100));
+	if (changed && !atomic_flag_test_and_set(&congestion->reporting)) {
+		atomic_store(&congestion->reported_level, level);
+		streaming_send_fill_level(stream, (uint8_t)level);
+		atomic_flag_clear(&congestion->reporting);
+	}
+	return (uint8_t)level;
+}
+
+bool streaming_congested(const struct stream *stream)
+{
+	return stream->congestion != NULL && atomic_load(&stream->congestion->congested);
+}
+
+/**
+ * min/max decimation keeps the peaks of the signal visible. The domain of the table changes along with the
+ * decimation, so the linear signals of the table are announced again.
+ */
+static void congestion_decimation_switch(signal_t *signal, bool on)
+{
+	signal_definition_t *def = signal->definition;
+	uint32_t factor = def->congestion_factor ? def->congestion_factor : STREAMING_CONGESTION_DECIMATION;
+
+	if (on) {
+		// min/max decimation needs an even factor
+		decimation_init(&signal->decimation, decimation_minmax, factor + factor % 2);
+	} else {
+		decimation_init(&signal->decimation, decimation_none, 0);
+	}
+	signal->congestion_decimated = on;
+	if (signal->table != NULL) {
+		signal_table_domain_changed(signal->table);
+	}
+	streaming_send_meta_signal(signal->stream, signal, 0);
+}
+
+/**
+ * the value signals of a table share the domain, so only the sole subscribed value signal can change its rate
+ */
+static bool congestion_decimation_possible(signal_t *signal)
+{
+	signal_definition_t *def = signal->definition;
+
+	if (signal->table != NULL && signal->table->subscribed_value_signal_count > 1) {
+		return false;
+	}
+	// a decimation or encoding chosen by the client is kept
+	return !decimation_active(&signal->decimation) && signal->encoding == encoding_none &&
+	       decimation_supported(def->datatype) && !quantization_active(def);
+}
+
+congestion_action_e streaming_congestion_admit(signal_t *signal)
+{
+	signal_definition_t *def = signal->definition;
+	const struct stream *stream = signal->stream;
+
+	if (stream != NULL && streaming_congested(stream)) {
+		streaming_congestion_recalculate(stream);
+	}
+	bool congested = stream != NULL && streaming_congested(stream);
+
+	switch (def->congestion) {
+	case congestion_discard:
+		return congested ? congestion_drop : congestion_send;
+	case congestion_decimate:
+		if (congested && !signal->congestion_decimated) {
+			if (congestion_decimation_possible(signal)) {
+				congestion_decimation_switch(signal, true);
+			}
+		} else if (!congested && signal->congestion_decimated && stream != NULL) {
+			congestion_decimation_switch(signal, false);
+		}
+		return congestion_send;
+	case congestion_block:
+	default:
+		return congestion_send;
+	}
+}
+
+void streaming_congestion_dropped(const struct stream *stream, uint32_t num)
+{
+	if (stream->congestion != NULL) {
+		atomic_fetch_add(&stream->congestion->dropped, num);
+	}
+}
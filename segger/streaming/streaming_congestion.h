@@ -0,0 +1,108 @@
+#ifndef _STREAMING_CONGESTION_H_
+#define _STREAMING_CONGESTION_H_
+
+#include "stream_id.h"
+#include "streaming_signals.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * congestion tracking per stream. The fill level of a stream is the larger percentage of
+ *  - the bytes queued in front of the network (stream->backlog) plus the bytes in blocking sends of other tasks,
+ *    of limit_bytes
+ *  - the zero-copy packets the network stack queued instead of sending them (streamp returned >0), of
+ *    limit_packets. A packet sent right away means the stack drained its queue. The stack does not report when a
+ *    queued packet left, so without new queued packets the count drops by one every
+ *    STREAMING_CONGESTION_PACKET_DECAY_MS.
+ *
+ * A stream becomes congested at a fill level of 100 and stays congested until the fill level drops to half of it.
+ * Changes of the fill level by STREAMING_FILLLEVEL_STEP are sent to the client as "fillLevel" meta information.
+ * The congestion policy of explicit signals decides what happens to their samples while the stream is congested.
+ */
+
+struct stream_congestion {
+	uint32_t limit_bytes;
+	uint32_t limit_packets;
+	atomic_uint_least32_t inflight_bytes;
+	atomic_uint_least32_t queued_packets;
+	// time in milliseconds the count of queued packets was last raised or decayed
+	atomic_uint_least32_t queued_ms;
+	atomic_uint_least32_t fill_level;
+	atomic_uint_least32_t reported_level;
+	atomic_bool congested;
+	// set while the fill level is sent, which goes through the tracked stream itself
+	atomic_flag reporting;
+	// samples discarded by congestion_discard
+	atomic_uint_least32_t dropped;
+};
+
+typedef struct stream_congestion stream_congestion_t;
+
+typedef enum {
+	congestion_send,
+	congestion_drop,
+} congestion_action_e;
+
+/**
+ * sets up congestion tracking for a stream
+ *
+ * @param stream the stream to track
+ * @param congestion state of the stream, must stay valid as long as the stream
+ * @param limit_bytes queued bytes at which the stream is congested, 0 ignores bytes
+ * @param limit_packets queued zero-copy packets at which the stream is congested, 0 ignores packets
+ */
+void streaming_congestion_init(struct stream *stream, stream_congestion_t *congestion, uint32_t limit_bytes,
+                               uint32_t limit_packets);
+
+/**
+ * accounts for a blocking send of bytes, called by the library around sends
+ */
+void streaming_congestion_begin(const struct stream *stream, size_t bytes);
+void streaming_congestion_end(const struct stream *stream, size_t bytes);
+
+/**
+ * accounts for the result of stream->streamp
+ *
+ * @return ret
+ */
+int streaming_congestion_packet_sent(const struct stream *stream, int ret);
+
+/**
+ * recalculates the fill level and sends it to the client if it changed enough
+ *
+ * @return fill level in percent
+ */
+uint8_t streaming_congestion_update(const struct stream *stream);
+
+/**
+ * recalculates the fill level and the congestion state without sending the fill level, the next
+ * streaming_congestion_update does. For tasks that write parts of packets downstream, e.g. the transmit task of a
+ * pipeline, where a fill level packet would end up in the middle of a packet.
+ *
+ * @return fill level in percent
+ */
+uint8_t streaming_congestion_recalculate(const struct stream *stream);
+
+/**
+ * whether the stream is congested, false for streams without congestion tracking
+ */
+bool streaming_congested(const struct stream *stream);
+
+/**
+ * applies the congestion policy of an explicit signal before its samples are sent. Switches congestion
+ * decimation on and off, the client is informed by new signal meta information. While the stream is congested
+ * the fill level is recalculated first, as discarded samples send nothing that would recalculate it.
+ *
+ * @return congestion_drop if the samples should be discarded, see streaming_congestion_dropped
+ *         congestion_send otherwise
+ */
+congestion_action_e streaming_congestion_admit(signal_t *signal);
+
+/**
+ * counts samples discarded because of congestion
+ */
+void streaming_congestion_dropped(const struct stream *stream, uint32_t num);
+
+#endif
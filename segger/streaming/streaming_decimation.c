@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "streaming_decimation.h"
+#include "streaming_endian.h"
+#include <math.h>
+#include <string.h>
+
+typedef enum {
+	value_class_signed,
+	value_class_unsigned,
+	value_class_real,
+} value_class_e;
+
+static value_class_e value_class(signal_data_type_e datatype)
+{
+	switch (datatype) {
+	case signal_type_uint8:
+	case signal_type_uint16:
+	case signal_type_uint32:
+	case signal_type_uint64:
+		return value_class_unsigned;
+	case signal_type_real32:
+	case signal_type_real64:
+		return value_class_real;
+	default:
+		return value_class_signed;
+	}
+}
+
+static inline decimation_value_t load_value(signal_data_type_e datatype, const unsigned char *src)
+{
+	decimation_value_t v;
+	switch (datatype) {
+	case signal_type_uint8:
+		v.u = *(const uint8_t *)src;
+		break;
+	case signal_type_uint16:
+		v.u = *(const uint16_t *)src;
+		break;
+	case signal_type_uint32:
+		v.u = *(const uint32_t *)src;
+		break;
+	case signal_type_uint64:
+		v.u = *(const uint64_t *)src;
+		break;
+	case signal_type_real32:
+		v.d = *(const float *)src;
+		break;
+	case signal_type_real64:
+		v.d = *(const double *)src;
+		break;
+	default:
+		streaming_sample_to_int64(datatype, src, &v.i);
+		break;
+	}
+	return v;
+}
+
+static inline double value_to_double(value_class_e cls, decimation_value_t v)
+{
+	switch (cls) {
+	case value_class_signed:
+		return (double)v.i;
+	case value_class_unsigned:
+		return (double)v.u;
+	default:
+		return v.d;
+	}
+}
+
+static inline bool value_less(value_class_e cls, decimation_value_t a, decimation_value_t b)
+{
+	switch (cls) {
+	case value_class_signed:
+		return a.i < b.i;
+	case value_class_unsigned:
+		return a.u < b.u;
+	default:
+		return a.d < b.d;
+	}
+}
+
+/**
+ * writes one value as sample of datatype in little endian byte order
+ */
+static void store_value(signal_data_type_e datatype, unsigned char *dst, decimation_value_t v)
+{
+	union {
+		int8_t i8;
+		int16_t i16;
+		int32_t i32;
+		int64_t i64;
+		uint8_t u8;
+		uint16_t u16;
+		uint32_t u32;
+		uint64_t u64;
+		float f;
+		double d;
+	} sample;
+
+	switch (datatype) {
+	case signal_type_int8:
+		sample.i8 = v.i;
+		break;
+	case signal_type_int16:
+		sample.i16 = v.i;
+		break;
+	case signal_type_int32:
+		sample.i32 = v.i;
+		break;
+	case signal_type_int64:
+		sample.i64 = v.i;
+		break;
+	case signal_type_uint8:
+		sample.u8 = v.u;
+		break;
+	case signal_type_uint16:
+		sample.u16 = v.u;
+		break;
+	case signal_type_uint32:
+		sample.u32 = v.u;
+		break;
+	case signal_type_uint64:
+		sample.u64 = v.u;
+		break;
+	case signal_type_real32:
+		sample.f = v.d;
+		break;
+	case signal_type_real64:
+		sample.d = v.d;
+		break;
+	default:
+		return;
+	}
+	streaming_copy_samples_le(datatype, dst, &sample, 1);
+}
+
+static decimation_value_t mean_value(value_class_e cls, const decimation_t *dec)
+{
+	decimation_value_t v;
+	double mean = dec->sum / dec->factor;
+	switch (cls) {
+	case value_class_signed:
+		v.i = llround(mean);
+		break;
+	case value_class_unsigned:
+		v.u = (uint64_t)llround(mean);
+		break;
+	default:
+		v.d = mean;
+		break;
+	}
+	return v;
+}
+
+bool decimation_supported(signal_data_type_e datatype)
+{
+	switch (datatype) {
+	case signal_type_int8:
+	case signal_type_uint8:
+	case signal_type_int16:
+	case signal_type_uint16:
+	case signal_type_int32:
+	case signal_type_uint32:
+	case signal_type_int64:
+	case signal_type_uint64:
+	case signal_type_real32:
+	case signal_type_real64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void decimation_init(decimation_t *dec, decimation_mode_e mode, uint32_t factor)
+{
+	memset(dec, 0, sizeof(*dec));
+	if (factor >= 2) {
+		dec->mode = mode;
+		dec->factor = factor;
+	}
+}
+
+bool decimation_valid(decimation_mode_e mode, uint32_t factor)
+{
+	// the maximum of a min/max bucket is placed in the middle of the bucket
+	return mode != decimation_minmax || factor < 2 || factor % 2 == 0;
+}
+
+static inline unsigned int samples_per_bucket(const decimation_t *dec)
+{
+	return dec->mode == decimation_minmax ? 2 : 1;
+}
+
+uint32_t decimation_domain_factor(const decimation_t *dec)
+{
+	if (!decimation_active(dec)) {
+		return 1;
+	}
+	return dec->factor / samples_per_bucket(dec);
+}
+
+unsigned int decimation_output_count(const decimation_t *dec, unsigned int num)
+{
+	return (dec->count + num) / dec->factor * samples_per_bucket(dec);
+}
+
+unsigned int decimation_input_limit(const decimation_t *dec, unsigned int max_out)
+{
+	unsigned int buckets = max_out / samples_per_bucket(dec);
+	if (buckets == 0) {
+		return 0;
+	}
+	// the samples of the incomplete bucket count towards the first output
+	return buckets * dec->factor - dec->count;
+}
+
+size_t decimation_run(decimation_t *dec, signal_data_type_e datatype, unsigned char *dst, const void *src,
+                      size_t stride, unsigned int num)
+{
+	const unsigned char *src_ptr = src;
+	size_t sample_size = openDAQ_get_sample_size(datatype);
+	value_class_e cls = value_class(datatype);
+	size_t len = 0;
+
+	for (unsigned int i = 0; i < num; i++, src_ptr += stride) {
+		decimation_value_t v = load_value(datatype, src_ptr);
+
+		if (dec->mode == decimation_mean) {
+			dec->sum += value_to_double(cls, v);
+		} else if (dec->count == 0) {
+			dec->min = v;
+			dec->max = v;
+		} else if (value_less(cls, v, dec->min)) {
+			dec->min = v;
+		} else if (value_less(cls, dec->max, v)) {
+			dec->max = v;
+		}
+
+		if (++dec->count < dec->factor) {
+			continue;
+		}
+
+		// bucket complete
+		if (dec->mode == decimation_mean) {
+			store_value(datatype, dst + len, mean_value(cls, dec));
+			len += sample_size;
+		} else {
+			store_value(datatype, dst + len, dec->min);
+			store_value(datatype, dst + len + sample_size, dec->max);
+			len += 2 * sample_size;
+		}
+		dec->count = 0;
+		dec->sum = 0;
+	}
+	return len;
+}
+
+const char *decimation_mode_to_string(decimation_mode_e mode)
+{
+	switch (mode) {
+	case decimation_minmax:
+		return "minmax";
+	case decimation_mean:
+		return "mean";
+	case decimation_none:
+		return "none";
+	}
+	return "unknown";
+}
+
+decimation_mode_e decimation_mode_from_string(const char *mode)
+{
+	if (!strcmp(mode, "minmax")) {
+		return decimation_minmax;
+	}
+	if (!strcmp(mode, "mean")) {
+		return decimation_mean;
+	}
+	return decimation_none;
+}
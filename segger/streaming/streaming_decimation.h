@@ -0,0 +1,69 @@
+#ifndef _STREAMING_DECIMATION_H_
+#define _STREAMING_DECIMATION_H_
+
+#include "streaming_signals.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * explicit signals can be reduced per subscription before serialization. Every factor input samples form
+ * a bucket, which is reduced to its minimum and maximum (two output samples) or its mean (one output sample).
+ * Buckets are continued across blocks.
+ *
+ * The output samples are evenly spaced in the domain of the table: a mean sample stands for its bucket,
+ * the minimum for the first and the maximum for the middle of its bucket. Min/max decimation therefore
+ * needs an even factor.
+ */
+
+/**
+ * whether signals of datatype can be decimated. Only integer types of up to 64 bit and real types are supported.
+ */
+bool decimation_supported(signal_data_type_e datatype);
+
+/**
+ * starts a new decimation, factors below 2 or mode decimation_none disable decimation
+ */
+void decimation_init(decimation_t *dec, decimation_mode_e mode, uint32_t factor);
+
+static inline bool decimation_active(const decimation_t *dec)
+{
+	return dec->mode != decimation_none;
+}
+
+/**
+ * whether a subscription may request mode and factor, see decimation_init for the factors which disable decimation
+ */
+bool decimation_valid(decimation_mode_e mode, uint32_t factor);
+
+/**
+ * number of input samples per output sample, which scales the delta of the linear domain of the table
+ */
+uint32_t decimation_domain_factor(const decimation_t *dec);
+
+/**
+ * number of output samples decimation_run produces for num input samples
+ */
+unsigned int decimation_output_count(const decimation_t *dec, unsigned int num);
+
+/**
+ * largest number of input samples for which decimation_run produces at most max_out output samples
+ */
+unsigned int decimation_input_limit(const decimation_t *dec, unsigned int max_out);
+
+/**
+ * reduces num samples at src, which are stride bytes apart, and writes the completed buckets to dst in little
+ * endian byte order. dst must hold decimation_output_count(dec, num) samples.
+ *
+ * @return number of bytes written to dst
+ */
+size_t decimation_run(decimation_t *dec, signal_data_type_e datatype, unsigned char *dst, const void *src,
+                      size_t stride, unsigned int num);
+
+const char *decimation_mode_to_string(decimation_mode_e mode);
+
+/**
+ * @return decimation_none if the string is not a known mode
+ */
+decimation_mode_e decimation_mode_from_string(const char *mode);
+
+#endif
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "streaming_encoding.h"
+#include "streaming_endian.h"
+#include <string.h>
+
+// samples are converted into blocks of 64 bit values first, so the encoding loops run on plain arrays
+#define ENCODING_BLOCK_SIZE 64
+
+static inline bool is_signed(signal_data_type_e datatype)
+{
+	return datatype == signal_type_int8 || datatype == signal_type_int16 || datatype == signal_type_int32 ||
+	       datatype == signal_type_int64;
+}
+
+/**
+ * flipping the sign bit of sign extended values maps signed values to unsigned values of the same order
+ */
+static inline uint64_t sign_flip(signal_data_type_e datatype)
+{
+	return is_signed(datatype) ? (uint64_t)1 << 63 : 0;
+}
+
+#define LOAD_BLOCK(type)                                                                                              \
+	for (size_t i = 0; i < num; i++) {                                                                                 \
+		type v;                                                                                                        \
+		memcpy(&v, src + i * stride, sizeof(v));                                                                       \
+		dst[i] = (uint64_t)v ^ flip;                                                                                   \
+	}
+
+static void load_block(signal_data_type_e datatype, uint64_t *dst, const unsigned char *src, size_t stride,
+                       size_t num)
+{
+	uint64_t flip = sign_flip(datatype);
+
+	switch (datatype) {
+	case signal_type_int8:
+		LOAD_BLOCK(int8_t);
+		break;
+	case signal_type_uint8:
+		LOAD_BLOCK(uint8_t);
+		break;
+	case signal_type_int16:
+		LOAD_BLOCK(int16_t);
+		break;
+	case signal_type_uint16:
+		LOAD_BLOCK(uint16_t);
+		break;
+	case signal_type_int32:
+		LOAD_BLOCK(int32_t);
+		break;
+	case signal_type_uint32:
+		LOAD_BLOCK(uint32_t);
+		break;
+	case signal_type_int64:
+		LOAD_BLOCK(int64_t);
+		break;
+	case signal_type_uint64:
+		LOAD_BLOCK(uint64_t);
+		break;
+	default:
+		memset(dst, 0, num * sizeof(*dst));
+		break;
+	}
+}
+
+static inline uint64_t zigzag(uint64_t delta)
+{
+	return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+}
+
+static inline size_t varint_size(uint64_t v)
+{
+	return (64 - __builtin_clzll(v | 1) + 6) / 7;
+}
+
+static inline size_t write_varint(unsigned char *dst, uint64_t v)
+{
+	size_t n = 0;
+	while (v >= 0x80) {
+		dst[n++] = (unsigned char)v | 0x80;
+		v >>= 7;
+	}
+	dst[n++] = (unsigned char)v;
+	return n;
+}
+
+static inline void write_le(unsigned char *dst, uint64_t v, size_t bytes)
+{
+	for (size_t i = 0; i < bytes; i++) {
+		dst[i] = (unsigned char)(v >> (8 * i));
+	}
+}
+
+bool encoding_supported(signal_data_type_e datatype)
+{
+	switch (datatype) {
+	case signal_type_int8:
+	case signal_type_uint8:
+	case signal_type_int16:
+	case signal_type_uint16:
+	case signal_type_int32:
+	case signal_type_uint32:
+	case signal_type_int64:
+	case signal_type_uint64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void encoding_begin(encoding_t *enc, encoding_mode_e mode, signal_data_type_e datatype)
+{
+	memset(enc, 0, sizeof(*enc));
+	enc->mode = mode;
+	enc->datatype = datatype;
+	enc->prev = sign_flip(datatype);
+	enc->min = UINT64_MAX;
+}
+
+void encoding_measure(encoding_t *enc, const void *src, size_t stride, size_t num)
+{
+	const unsigned char *src_ptr = src;
+	uint64_t block[ENCODING_BLOCK_SIZE];
+
+	while (num > 0) {
+		size_t n = num < ENCODING_BLOCK_SIZE ? num : ENCODING_BLOCK_SIZE;
+		load_block(enc->datatype, block, src_ptr, stride, n);
+
+		if (enc->mode == encoding_delta_varint) {
+			uint64_t prev = enc->prev;
+			size_t size = 0;
+			for (size_t i = 0; i < n; i++) {
+				size += varint_size(zigzag(block[i] - prev));
+				prev = block[i];
+			}
+			enc->prev = prev;
+			enc->size += size;
+		} else {
+			uint64_t min = enc->min;
+			uint64_t max = enc->max;
+			for (size_t i = 0; i < n; i++) {
+				min = block[i] < min ? block[i] : min;
+				max = block[i] > max ? block[i] : max;
+			}
+			enc->min = min;
+			enc->max = max;
+		}
+
+		enc->num += n;
+		src_ptr += n * stride;
+		num -= n;
+	}
+}
+
+size_t encoding_size(encoding_t *enc)
+{
+	if (enc->mode == encoding_frame_of_reference) {
+		uint64_t range = enc->num > 0 ? enc->max - enc->min : 0;
+		enc->width = range ? 64 - __builtin_clzll(range) : 0;
+		enc->size = varint_size(enc->num) + 1 + openDAQ_get_sample_size(enc->datatype) +
+		            ((uint64_t)enc->num * enc->width + 7) / 8;
+	}
+	return enc->size;
+}
+
+size_t encoding_max_sample_size(encoding_mode_e mode, signal_data_type_e datatype)
+{
+	size_t sample_size = openDAQ_get_sample_size(datatype);
+
+	if (mode == encoding_delta_varint) {
+		// the zigzag mapped difference has one bit more than the sample
+		return (sample_size * 8 + 7) / 7;
+	}
+	return sample_size;
+}
+
+size_t encoding_max_size(encoding_mode_e mode, signal_data_type_e datatype, size_t num)
+{
+	size_t payload_size = num * encoding_max_sample_size(mode, datatype);
+
+	if (mode == encoding_frame_of_reference) {
+		payload_size += varint_size(num) + 1 + openDAQ_get_sample_size(datatype);
+	}
+	return payload_size;
+}
+
+size_t encoding_write_header(encoding_t *enc, unsigned char *dst)
+{
+	enc->prev = sign_flip(enc->datatype);
+	enc->bits = 0;
+	enc->bit_count = 0;
+
+	if (enc->mode != encoding_frame_of_reference) {
+		return 0;
+	}
+
+	size_t sample_size = openDAQ_get_sample_size(enc->datatype);
+	size_t len = write_varint(dst, enc->num);
+	dst[len++] = enc->width;
+	write_le(dst + len, enc->num > 0 ? enc->min ^ sign_flip(enc->datatype) : 0, sample_size);
+	return len + sample_size;
+}
+
+size_t encoding_write(encoding_t *enc, unsigned char *dst, const void *src, size_t stride, size_t num)
+{
+	const unsigned char *src_ptr = src;
+	unsigned char *dst_ptr = dst;
+	uint64_t block[ENCODING_BLOCK_SIZE];
+
+	while (num > 0) {
+		size_t n = num < ENCODING_BLOCK_SIZE ? num : ENCODING_BLOCK_SIZE;
+		load_block(enc->datatype, block, src_ptr, stride, n);
+
+		if (enc->mode == encoding_delta_varint) {
+			uint64_t prev = enc->prev;
+			for (size_t i = 0; i < n; i++) {
+				dst_ptr += write_varint(dst_ptr, zigzag(block[i] - prev));
+				prev = block[i];
+			}
+			enc->prev = prev;
+		} else if (enc->width > 0) {
+			uint64_t bits = enc->bits;
+			unsigned int bit_count = enc->bit_count;
+			unsigned int width = enc->width;
+			for (size_t i = 0; i < n; i++) {
+				uint64_t v = block[i] - enc->min;
+				bits |= v << bit_count;
+				if (bit_count + width < 64) {
+					bit_count += width;
+					continue;
+				}
+				// 64 bits complete, the remaining high bits of v start the next word
+				write_le(dst_ptr, bits, sizeof(bits));
+				dst_ptr += sizeof(bits);
+				bits = bit_count ? v >> (64 - bit_count) : 0;
+				bit_count = bit_count + width - 64;
+			}
+			enc->bits = bits;
+			enc->bit_count = bit_count;
+		}
+
+		src_ptr += n * stride;
+		num -= n;
+	}
+	return dst_ptr - dst;
+}
+
+size_t encoding_finish(encoding_t *enc, unsigned char *dst)
+{
+	size_t len = (enc->bit_count + 7) / 8;
+	write_le(dst, enc->bits, len);
+	enc->bits = 0;
+	enc->bit_count = 0;
+	return len;
+}
+
+const char *encoding_mode_to_string(encoding_mode_e mode)
+{
+	switch (mode) {
+	case encoding_delta_varint:
+		return "deltaVarint";
+	case encoding_frame_of_reference:
+		return "frameOfReference";
+	case encoding_none:
+		return "none";
+	}
+	return "unknown";
+}
+
+encoding_mode_e encoding_mode_from_string(const char *mode)
+{
+	if (!strcmp(mode, "deltaVarint")) {
+		return encoding_delta_varint;
+	}
+	if (!strcmp(mode, "frameOfReference")) {
+		return encoding_frame_of_reference;
+	}
+	return encoding_none;
+}
@@ -0,0 +1,104 @@
+#ifndef _STREAMING_ENCODING_H_
+#define _STREAMING_ENCODING_H_
+
+#include "streaming_signals.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * explicit signals of integer datatypes can be sent with an encoded payload instead of raw samples.
+ * Every packet is encoded on its own, so a client can decode each packet without any previous packets.
+ *
+ * encoding_delta_varint ("deltaVarint"):
+ *   for every sample the difference to the previous sample (0 for the first sample) is zigzag mapped
+ *   and written as LEB128 varint. The number of samples is given by the end of the payload.
+ *
+ * encoding_frame_of_reference ("frameOfReference"):
+ *   varint number of samples, one byte bit width w, the smallest sample (reference) as little endian
+ *   sample of the datatype, followed by sample - reference for all samples with w bits each, packed
+ *   least significant bit first. The last byte is padded with zero bits.
+ *
+ * Encoding a packet takes two passes. encoding_measure is called for all sample spans of the packet to
+ * calculate the payload size, afterwards encoding_write_header, encoding_write for the same spans and
+ * encoding_finish produce the payload.
+ */
+
+// largest payload header of encoding_write_header: varint number of samples, bit width and reference sample
+#define ENCODING_HEADER_SIZE_MAX (5 + 1 + sizeof(uint64_t))
+
+// state of one packet being encoded
+typedef struct {
+	encoding_mode_e mode;
+	signal_data_type_e datatype;
+	uint32_t num;
+	size_t size;
+	// samples are handled as unsigned values with the sign bit flipped for signed datatypes, which keeps the order
+	uint64_t prev;
+	uint64_t min;
+	uint64_t max;
+	uint8_t width;
+	uint64_t bits;
+	unsigned int bit_count;
+} encoding_t;
+
+/**
+ * whether signals of datatype can be encoded. Only integer types of up to 64 bit are supported.
+ */
+bool encoding_supported(signal_data_type_e datatype);
+
+/**
+ * starts measuring a new packet
+ */
+void encoding_begin(encoding_t *enc, encoding_mode_e mode, signal_data_type_e datatype);
+
+/**
+ * first pass: accounts for num samples at src, which are stride bytes apart
+ */
+void encoding_measure(encoding_t *enc, const void *src, size_t stride, size_t num);
+
+/**
+ * @return size in bytes of the encoded payload of all measured samples
+ */
+size_t encoding_size(encoding_t *enc);
+
+/**
+ * upper bound of the encoded payload size of num samples
+ */
+size_t encoding_max_size(encoding_mode_e mode, signal_data_type_e datatype, size_t num);
+
+/**
+ * upper bound of the number of bytes encoding_write produces per sample
+ */
+size_t encoding_max_sample_size(encoding_mode_e mode, signal_data_type_e datatype);
+
+/**
+ * second pass: writes the payload header. Must be called after encoding_size.
+ *
+ * @return number of bytes written
+ */
+size_t encoding_write_header(encoding_t *enc, unsigned char *dst);
+
+/**
+ * second pass: encodes num samples at src, which are stride bytes apart. dst must hold
+ * encoding_max_size(mode, datatype, num) bytes.
+ *
+ * @return number of bytes written
+ */
+size_t encoding_write(encoding_t *enc, unsigned char *dst, const void *src, size_t stride, size_t num);
+
+/**
+ * second pass: writes pending bits
+ *
+ * @return number of bytes written
+ */
+size_t encoding_finish(encoding_t *enc, unsigned char *dst);
+
+const char *encoding_mode_to_string(encoding_mode_e mode);
+
+/**
+ * @return encoding_none if the string is not a known encoding
+ */
+encoding_mode_e encoding_mode_from_string(const char *mode);
+
+#endif
@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "streaming_endian.h"
+#include <stdint.h>
+#include <string.h>
+
+#if STREAMING_BIG_ENDIAN
+/**
+ * the big endian kernels load one 64 bit word at a time and swap all samples inside the word at once.
+ * memcpy is used for the loads and stores, so unaligned buffers are fine and the compiler is free
+ * to turn the loops into vector instructions.
+ */
+static inline uint64_t load64(const unsigned char *src)
+{
+	uint64_t w;
+	memcpy(&w, src, sizeof(w));
+	return w;
+}
+
+static inline void store64(unsigned char *dst, uint64_t w)
+{
+	memcpy(dst, &w, sizeof(w));
+}
+#endif
+
+int openDAQ_get_sample_size(signal_data_type_e datatype)
+{
+	switch (datatype) {
+	case signal_type_int8:
+	case signal_type_uint8:
+	case signal_type_bitfield8:
+		return sizeof(uint8_t);
+	case signal_type_int16:
+	case signal_type_uint16:
+	case signal_type_bitfield16:
+		return sizeof(uint16_t);
+	case signal_type_int32:
+	case signal_type_uint32:
+	case signal_type_real32:
+	case signal_type_bitfield32:
+		return sizeof(uint32_t);
+	case signal_type_int64:
+	case signal_type_uint64:
+	case signal_type_real64:
+	case signal_type_bitfield64:
+		return sizeof(uint64_t);
+	case signal_type_complex32:
+		return sizeof(uint32_t) * 2;
+	case signal_type_complex64:
+		return sizeof(uint64_t) * 2;
+	case signal_type_int128:
+	case signal_type_uint128:
+		return 16;
+	case signal_type_struct:
+		// the size of a record is given by its struct object
+		return 0;
+	}
+	return 0;
+}
+
+bool streaming_sample_to_int64(signal_data_type_e datatype, const void *src, int64_t *value)
+{
+	switch (datatype) {
+	case signal_type_int8:
+		*value = *(const int8_t *)src;
+		return true;
+	case signal_type_uint8:
+	case signal_type_bitfield8:
+		*value = *(const uint8_t *)src;
+		return true;
+	case signal_type_int16:
+		*value = *(const int16_t *)src;
+		return true;
+	case signal_type_uint16:
+	case signal_type_bitfield16:
+		*value = *(const uint16_t *)src;
+		return true;
+	case signal_type_int32:
+		*value = *(const int32_t *)src;
+		return true;
+	case signal_type_uint32:
+	case signal_type_bitfield32:
+		*value = *(const uint32_t *)src;
+		return true;
+	case signal_type_int64:
+	case signal_type_uint64:
+	case signal_type_bitfield64:
+		// two's complement, unsigned values above INT64_MAX wrap consistently
+		memcpy(value, src, sizeof(*value));
+		return true;
+	default:
+		return false;
+	}
+}
+
+void streaming_samples_to_double(signal_data_type_e datatype, double *dst, const void *src, size_t num)
+{
+	const unsigned char *src_ptr = src;
+
+	switch (datatype) {
+	case signal_type_real32:
+		for (size_t i = 0; i < num; i++) {
+			float v;
+			memcpy(&v, src_ptr + i * sizeof(v), sizeof(v));
+			dst[i] = v;
+		}
+		break;
+	case signal_type_real64:
+		memcpy(dst, src, num * sizeof(*dst));
+		break;
+	case signal_type_uint64:
+		for (size_t i = 0; i < num; i++) {
+			uint64_t v;
+			memcpy(&v, src_ptr + i * sizeof(v), sizeof(v));
+			dst[i] = (double)v;
+		}
+		break;
+	default: {
+		size_t sample_size = openDAQ_get_sample_size(datatype);
+		for (size_t i = 0; i < num; i++) {
+			// unsupported datatypes convert to 0
+			int64_t v = 0;
+			streaming_sample_to_int64(datatype, src_ptr + i * sample_size, &v);
+			dst[i] = (double)v;
+		}
+		break;
+	}
+	}
+}
+
+void streaming_copy_le8(void *dst, const void *src, size_t count)
+{
+	memcpy(dst, src, count);
+}
+
+void streaming_copy_le16(void *dst, const void *src, size_t count)
+{
+#if STREAMING_BIG_ENDIAN
+	unsigned char *d = dst;
+	const unsigned char *s = src;
+	size_t words = count / 4;
+
+	// four samples per word: swap the bytes inside each 16 bit lane
+	for (size_t i = 0; i < words; i++) {
+		uint64_t w = load64(s);
+		w = ((w & 0x00ff00ff00ff00ffULL) << 8) | ((w >> 8) & 0x00ff00ff00ff00ffULL);
+		store64(d, w);
+		s += 8;
+		d += 8;
+	}
+	for (size_t i = words * 4; i < count; i++) {
+		uint16_t v;
+		memcpy(&v, s, sizeof(v));
+		v = streaming_bswap16(v);
+		memcpy(d, &v, sizeof(v));
+		s += 2;
+		d += 2;
+	}
+#else
+	memcpy(dst, src, count * sizeof(uint16_t));
+#endif
+}
+
+void streaming_copy_le32(void *dst, const void *src, size_t count)
+{
+#if STREAMING_BIG_ENDIAN
+	unsigned char *d = dst;
+	const unsigned char *s = src;
+	size_t words = count / 2;
+
+	// two samples per word: swap the bytes inside each 32 bit lane
+	for (size_t i = 0; i < words; i++) {
+		uint64_t w = load64(s);
+		w = ((w & 0x00ff00ff00ff00ffULL) << 8) | ((w >> 8) & 0x00ff00ff00ff00ffULL);
+		w = ((w & 0x0000ffff0000ffffULL) << 16) | ((w >> 16) & 0x0000ffff0000ffffULL);
+		store64(d, w);
+		s += 8;
+		d += 8;
+	}
+	if (count & 1) {
+		uint32_t v;
+		memcpy(&v, s, sizeof(v));
+		v = streaming_bswap32(v);
+		memcpy(d, &v, sizeof(v));
+	}
+#else
+	memcpy(dst, src, count * sizeof(uint32_t));
+#endif
+}
+
+void streaming_copy_le64(void *dst, const void *src, size_t count)
+{
+#if STREAMING_BIG_ENDIAN
+	unsigned char *d = dst;
+	const unsigned char *s = src;
+
+	for (size_t i = 0; i < count; i++) {
+		store64(d, streaming_bswap64(load64(s)));
+		s += 8;
+		d += 8;
+	}
+#else
+	memcpy(dst, src, count * sizeof(uint64_t));
+#endif
+}
+
+void streaming_copy_le128(void *dst, const void *src, size_t count)
+{
+#if STREAMING_BIG_ENDIAN
+	unsigned char *d = dst;
+	const unsigned char *s = src;
+
+	// the most significant half comes first on big endian targets
+	for (size_t i = 0; i < count; i++) {
+		uint64_t hi = load64(s);
+		uint64_t lo = load64(s + 8);
+		store64(d, streaming_bswap64(lo));
+		store64(d + 8, streaming_bswap64(hi));
+		s += 16;
+		d += 16;
+	}
+#else
+	memcpy(dst, src, count * 16);
+#endif
+}
+
+void streaming_copy_samples_le(signal_data_type_e datatype, void *dst, const void *src, size_t num)
+{
+	switch (datatype) {
+	case signal_type_int8:
+	case signal_type_uint8:
+	case signal_type_bitfield8:
+		streaming_copy_le8(dst, src, num);
+		break;
+	case signal_type_int16:
+	case signal_type_uint16:
+	case signal_type_bitfield16:
+		streaming_copy_le16(dst, src, num);
+		break;
+	case signal_type_int32:
+	case signal_type_uint32:
+	case signal_type_real32:
+	case signal_type_bitfield32:
+		streaming_copy_le32(dst, src, num);
+		break;
+	case signal_type_int64:
+	case signal_type_uint64:
+	case signal_type_real64:
+	case signal_type_bitfield64:
+		streaming_copy_le64(dst, src, num);
+		break;
+	case signal_type_complex32:
+		// real and imaginary part are swapped individually
+		streaming_copy_le32(dst, src, num * 2);
+		break;
+	case signal_type_complex64:
+		streaming_copy_le64(dst, src, num * 2);
+		break;
+	case signal_type_int128:
+	case signal_type_uint128:
+		streaming_copy_le128(dst, src, num);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * strided kernels copy one sample per iteration. The sample width is fixed per kernel, so each memcpy
+ * compiles to a single load and store.
+ */
+static void copy_le8_strided(unsigned char *dst, size_t dst_stride, const unsigned char *src, size_t src_stride,
+                             size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		*dst = *src;
+		src += src_stride;
+		dst += dst_stride;
+	}
+}
+
+static void copy_le16_strided(unsigned char *dst, size_t dst_stride, const unsigned char *src, size_t src_stride,
+                              size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		uint16_t v;
+		memcpy(&v, src, sizeof(v));
+#if STREAMING_BIG_ENDIAN
+		v = streaming_bswap16(v);
+#endif
+		memcpy(dst, &v, sizeof(v));
+		src += src_stride;
+		dst += dst_stride;
+	}
+}
+
+static void copy_le32_strided(unsigned char *dst, size_t dst_stride, const unsigned char *src, size_t src_stride,
+                              size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		uint32_t v;
+		memcpy(&v, src, sizeof(v));
+#if STREAMING_BIG_ENDIAN
+		v = streaming_bswap32(v);
+#endif
+		memcpy(dst, &v, sizeof(v));
+		src += src_stride;
+		dst += dst_stride;
+	}
+}
+
+static void copy_le64_strided(unsigned char *dst, size_t dst_stride, const unsigned char *src, size_t src_stride,
+                              size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		uint64_t v;
+		memcpy(&v, src, sizeof(v));
+#if STREAMING_BIG_ENDIAN
+		v = streaming_bswap64(v);
+#endif
+		memcpy(dst, &v, sizeof(v));
+		src += src_stride;
+		dst += dst_stride;
+	}
+}
+
+void streaming_copy_samples_le_strided(signal_data_type_e datatype, void *dst, size_t dst_stride, const void *src,
+                                       size_t src_stride, size_t num)
+{
+	size_t sample_size = openDAQ_get_sample_size(datatype);
+	unsigned char *d = dst;
+	const unsigned char *s = src;
+
+	if (dst_stride == sample_size && src_stride == sample_size) {
+		streaming_copy_samples_le(datatype, dst, src, num);
+		return;
+	}
+
+	switch (datatype) {
+	case signal_type_int8:
+	case signal_type_uint8:
+	case signal_type_bitfield8:
+		copy_le8_strided(d, dst_stride, s, src_stride, num);
+		break;
+	case signal_type_int16:
+	case signal_type_uint16:
+	case signal_type_bitfield16:
+		copy_le16_strided(d, dst_stride, s, src_stride, num);
+		break;
+	case signal_type_int32:
+	case signal_type_uint32:
+	case signal_type_real32:
+	case signal_type_bitfield32:
+		copy_le32_strided(d, dst_stride, s, src_stride, num);
+		break;
+	case signal_type_int64:
+	case signal_type_uint64:
+	case signal_type_real64:
+	case signal_type_bitfield64:
+		copy_le64_strided(d, dst_stride, s, src_stride, num);
+		break;
+	case signal_type_complex32:
+		// real and imaginary part are swapped individually
+		copy_le32_strided(d, dst_stride, s, src_stride, num);
+		copy_le32_strided(d + 4, dst_stride, s + 4, src_stride, num);
+		break;
+	case signal_type_complex64:
+		copy_le64_strided(d, dst_stride, s, src_stride, num);
+		copy_le64_strided(d + 8, dst_stride, s + 8, src_stride, num);
+		break;
+	case signal_type_int128:
+	case signal_type_uint128:
+#if STREAMING_BIG_ENDIAN
+		// the most significant half comes first on big endian targets
+		copy_le64_strided(d, dst_stride, s + 8, src_stride, num);
+		copy_le64_strided(d + 8, dst_stride, s, src_stride, num);
+#else
+		copy_le64_strided(d, dst_stride, s, src_stride, num);
+		copy_le64_strided(d + 8, dst_stride, s + 8, src_stride, num);
+#endif
+		break;
+	default:
+		break;
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef _STREAMING_ENDIAN_H_
+#define _STREAMING_ENDIAN_H_
+
+#include "streaming_config.h"
+#include "streaming_signals.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * byte swaps. GCC and clang provide builtins which compile to a single instruction, other compilers
+ * get the shift and mask fallback.
+ */
+static inline uint16_t streaming_bswap16(uint16_t v)
+{
+#if defined(__GNUC__)
+	return __builtin_bswap16(v);
+#else
+	return (uint16_t)((v << 8) | (v >> 8));
+#endif
+}
+
+static inline uint32_t streaming_bswap32(uint32_t v)
+{
+#if defined(__GNUC__)
+	return __builtin_bswap32(v);
+#else
+	v = ((v & 0x00ff00ffu) << 8) | ((v >> 8) & 0x00ff00ffu);
+	return (v << 16) | (v >> 16);
+#endif
+}
+
+static inline uint64_t streaming_bswap64(uint64_t v)
+{
+#if defined(__GNUC__)
+	return __builtin_bswap64(v);
+#else
+	v = ((v & 0x00ff00ff00ff00ffULL) << 8) | ((v >> 8) & 0x00ff00ff00ff00ffULL);
+	v = ((v & 0x0000ffff0000ffffULL) << 16) | ((v >> 16) & 0x0000ffff0000ffffULL);
+	return (v << 32) | (v >> 32);
+#endif
+}
+
+/**
+ * size in bytes of one sample of datatype
+ */
+int openDAQ_get_sample_size(signal_data_type_e datatype);
+
+/**
+ * reads one sample of an integer or bitfield datatype of up to 64 bit as int64_t
+ *
+ * @return false if datatype is not an integer or bitfield type of up to 64 bit
+ */
+bool streaming_sample_to_int64(signal_data_type_e datatype, const void *src, int64_t *value);
+
+/**
+ * converts num samples of an integer type of up to 64 bit or a real type in host byte order to double
+ */
+void streaming_samples_to_double(signal_data_type_e datatype, double *dst, const void *src, size_t num);
+
+/**
+ * bulk copy kernels which copy count samples of one width from src to dst in little endian byte order.
+ * On little endian targets they fall back to memcpy, on big endian targets the samples are swapped word-wise.
+ * src and dst may be unaligned but must not overlap.
+ */
+void streaming_copy_le8(void *dst, const void *src, size_t count);
+void streaming_copy_le16(void *dst, const void *src, size_t count);
+void streaming_copy_le32(void *dst, const void *src, size_t count);
+void streaming_copy_le64(void *dst, const void *src, size_t count);
+void streaming_copy_le128(void *dst, const void *src, size_t count);
+
+/**
+ * copies num samples of datatype from src to dst in little endian byte order.
+ * The kernel is selected once per call.
+ *
+ * @param datatype data type of the samples
+ * @param dst destination buffer
+ * @param src source samples in host byte order
+ * @param num number of samples to copy
+ */
+void streaming_copy_samples_le(signal_data_type_e datatype, void *dst, const void *src, size_t num);
+
+/**
+ * copies num samples of datatype from src to dst in little endian byte order. Consecutive samples are
+ * src_stride bytes apart in the source and dst_stride bytes apart in the destination, e.g. to de-interleave
+ * channels of an interleaved acquisition buffer.
+ *
+ * @param datatype data type of the samples
+ * @param dst destination buffer
+ * @param dst_stride distance in bytes between two samples in dst
+ * @param src source samples in host byte order
+ * @param src_stride distance in bytes between two samples in src
+ * @param num number of samples to copy
+ */
+void streaming_copy_samples_le_strided(signal_data_type_e datatype, void *dst, size_t dst_stride, const void *src,
+                                       size_t src_stride, size_t num);
+
+#endif
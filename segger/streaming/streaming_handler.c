@@ -24,11 +24,13 @@
 #include "streaming_meta.h"
 #include "streaming_packet.h"
 #include "streaming_signals.h"
+#include "streaming_trigger.h"
 #include "streaming_websocket_rx.h"
 #include <stdio.h>
 
 struct streaming_callbacks *streaming_cbs;
 static char stream_id[9];
+static struct stream *served_stream = &single_stream;
 
 #if WEBSOCKET_STREAMING
 #define IP_WEBSOCKET_CLOSE_CODE_TRY_AGAIN_LATER 1013
@@ -68,6 +70,8 @@ static const IP_WEBS_WEBSOCKET_API StreamingWebSocketApi = {websocket_acceptKey_
 void streaming_init(struct streaming_callbacks *streaming_cb)
 {
 	signals_init();
+	triggers_init();
+	streaming_streams_init();
 	snprintf(stream_id, sizeof(stream_id), "%08X", (rand() << 16) + rand());
 #if STREAMING_INCLUDE_CONFIG_CHANNEL
 	streaming_jsonrpc_init(stream_id);
@@ -106,7 +110,11 @@ void streaming_start(void)
 #endif
 
 		setsockopt(handle, SOL_SOCKET, SO_CALLBACK, (void *)streaming_rx_callback, 0);
-		struct stream *stream = stream_malloc(handle, stream_id);
+		struct stream *socket_stream = stream_malloc(handle, stream_id);
+		struct stream *stream = socket_stream;
+		if (streaming_cbs->on_wrap != NULL)
+			stream = streaming_cbs->on_wrap(socket_stream);
+		served_stream = stream;
 		streaming_send_meta_stream(stream);
 		signals_send_all_avail(stream);
 		if (streaming_cbs->on_connect != NULL)
@@ -119,8 +127,11 @@ void streaming_start(void)
 		}
 
 		// Error might indicate we ran out of network buffers or the socket is closed
+		served_stream = &single_stream;
 		signals_purge_stream(stream);
-		stream_free(stream);
+		if (streaming_cbs->on_disconnect != NULL)
+			streaming_cbs->on_disconnect(stream);
+		stream_free(socket_stream);
 #ifdef WEBSOCKET_STREAMING
 		OS_MAILBOX_Purge(&mb);
 #endif
@@ -129,11 +140,19 @@ void streaming_start(void)
 	OS_TASK_Terminate(NULL);
 }
 
+struct stream *streaming_served_stream(void)
+{
+	return served_stream;
+}
+
 int streaming_send_avail(const struct stream *stream, signal_t **signalz, int num_signals)
 {
 	tl_packet_t packet = {0};
 	char mpack_buff[MSGPACK_BUF_SIZE];
 	int mpack_size = build_mpack_meta_stream_avail(mpack_buff, sizeof(mpack_buff), signalz, num_signals);
+	if (mpack_size < 0) {
+		return mpack_size;
+	}
 	build_packet_meta_stream(&packet, mpack_buff, mpack_size);
 	return openDAQ_streaming_send_packet(stream, &packet);
 }
@@ -143,6 +162,9 @@ int streaming_send_subscribed(const struct stream *stream, signal_t *signal)
 	tl_packet_t packet = {0};
 	char mpack_buff[MSGPACK_BUF_SIZE];
 	int mpack_size = build_mpack_meta_signal_subscribed(mpack_buff, sizeof(mpack_buff), signal->definition->name);
+	if (mpack_size < 0) {
+		return mpack_size;
+	}
 	build_packet_meta_signal(&packet, mpack_buff, mpack_size, signal_get_signal_no(signal));
 	return openDAQ_streaming_send_packet(stream, &packet);
 }
@@ -152,6 +174,9 @@ int streaming_send_unsubscribed(const struct stream *stream, signal_t *signal)
 	tl_packet_t packet = {0};
 	char mpack_buff[MSGPACK_BUF_SIZE];
 	int mpack_size = build_mpack_meta_signal_unsubscribed(mpack_buff, sizeof(mpack_buff));
+	if (mpack_size < 0) {
+		return mpack_size;
+	}
 	build_packet_meta_signal(&packet, mpack_buff, mpack_size, signal_get_signal_no(signal));
 	return openDAQ_streaming_send_packet(stream, &packet);
 }
@@ -161,15 +186,33 @@ int streaming_send_meta_signal(const struct stream *stream, signal_t *signal, ui
 	tl_packet_t packet = {0};
 	char mpack_buff[MSGPACK_BUF_SIZE];
 	int mpack_size = build_mpack_meta_signal(mpack_buff, sizeof(mpack_buff), signal, valueIndex);
+	if (mpack_size < 0) {
+		return mpack_size;
+	}
 	build_packet_meta_signal(&packet, mpack_buff, mpack_size, signal_get_signal_no(signal));
 	return openDAQ_streaming_send_packet(stream, &packet);
 }
 
+int streaming_send_fill_level(const struct stream *stream, uint8_t fill_level)
+{
+	tl_packet_t packet = {0};
+	char mpack_buff[MSGPACK_BUF_SIZE];
+	int mpack_size = build_mpack_meta_stream_fill_level(mpack_buff, sizeof(mpack_buff), fill_level);
+	if (mpack_size < 0) {
+		return mpack_size;
+	}
+	build_packet_meta_stream(&packet, mpack_buff, mpack_size);
+	return openDAQ_streaming_send_packet(stream, &packet);
+}
+
 int streaming_send_meta_stream(struct stream *stream)
 {
 	tl_packet_t packet = {0};
 	char mpack_buff[MSGPACK_BUF_SIZE];
 	int mpack_size = build_mpack_meta_stream_version(mpack_buff, sizeof(mpack_buff));
+	if (mpack_size < 0) {
+		return mpack_size;
+	}
 	build_packet_meta_stream(&packet, mpack_buff, mpack_size);
 	int ret = openDAQ_streaming_send_packet(stream, &packet);
 	if (ret < 0) {
@@ -177,6 +220,9 @@ int streaming_send_meta_stream(struct stream *stream)
 	}
 
 	mpack_size = build_mpack_meta_stream_init(mpack_buff, sizeof(mpack_buff), stream->id);
+	if (mpack_size < 0) {
+		return mpack_size;
+	}
 	build_packet_meta_stream(&packet, mpack_buff, mpack_size);
 	return openDAQ_streaming_send_packet(stream, &packet);
 }
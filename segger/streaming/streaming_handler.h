@@ -8,21 +8,40 @@
 typedef uint64_t subscribe_callback(const struct stream *stream, signal_t *signal);
 typedef void unsubscribe_callback(const struct stream *stream, signal_t *signal);
 typedef void connect_callback(const struct stream *stream);
+typedef struct stream *wrap_callback(struct stream *stream);
 
 struct streaming_callbacks {
 	connect_callback *on_connect;
 	subscribe_callback *on_subscribe;
 	unsubscribe_callback *on_unsubscribe;
+	// optional, called before the stream of a closed connection is freed
+	connect_callback *on_disconnect;
+	// optional, returns the stream a new connection is served through, e.g. the stream of a scheduler in front of
+	// the socket stream. All other callbacks get the returned stream.
+	wrap_callback *on_wrap;
 };
 
 void streaming_init(struct streaming_callbacks *streaming_cb);
 void streaming_start(void);
 
+/**
+ * the stream the current connection is served through, the socket stream or the stream returned by on_wrap.
+ * Subscriptions of the config channel go to this stream.
+ */
+struct stream *streaming_served_stream(void);
+
+/**
+ * the meta information is built into MSGPACK_BUF_SIZE bytes
+ *
+ * @return <0 the meta information does not fit or the send failed
+ *         >=0 success
+ */
 int streaming_send_avail(const struct stream *stream, signal_t **signals, int num_signals);
 int streaming_send_unavail(const struct stream *stream, signal_t **signals, int num_signals);
 int streaming_send_subscribed(const struct stream *stream, signal_t *signal);
 int streaming_send_unsubscribed(const struct stream *stream, signal_t *signal);
 int streaming_send_meta_stream(struct stream *stream);
 int streaming_send_meta_signal(const struct stream *stream, signal_t *signal, uint64_t valueIndex);
+int streaming_send_fill_level(const struct stream *stream, uint8_t fill_level);
 
 #endif
@@ -18,8 +18,13 @@
 #include "IP_Webserver.h"
 #include "mjson/src/mjson.h"
 #include "mpack.h"
+#include "streaming_decimation.h"
+#include "streaming_encoding.h"
+#include "streaming_handler.h"
 #include "streaming_signals.h"
+#include "streaming_trigger.h"
 #include <stdio.h>
+#include <string.h>
 
 static struct jsonrpc_ctx ctx;
 static WEBS_METHOD_HOOK streaming_hook;
@@ -30,16 +35,69 @@ static int rpc_sender(const char *data_to_send, int data_len, void *privdata)
 	return data_len;
 }
 
+/**
+ * reads element i of the subscribe params. An element is either a signal id or an object with an optional
+ * decimation or encoding, e.g. {"signalId": "ai0", "decimation": {"mode": "minmax", "factor": 100}}
+ *
+ * @return 1 element read, 0 no more elements, <0 invalid element
+ */
+static int rpc_get_subscribe_param(struct jsonrpc_request *req, int i, char *signal_id, int len,
+                                   subscribe_options_t *options)
+{
+	char path[32];
+	char mode_str[20];
+	double num;
+
+	options->decimation = decimation_none;
+	options->factor = 0;
+	options->encoding = encoding_none;
+
+	snprintf(path, sizeof(path), "$[%d]", i);
+	if (mjson_get_string(req->params, req->params_len, path, signal_id, len) >= 1) {
+		return 1;
+	}
+
+	snprintf(path, sizeof(path), "$[%d].signalId", i);
+	if (mjson_get_string(req->params, req->params_len, path, signal_id, len) < 1) {
+		return 0;
+	}
+
+	snprintf(path, sizeof(path), "$[%d].encoding", i);
+	if (mjson_get_string(req->params, req->params_len, path, mode_str, sizeof(mode_str)) >= 1) {
+		options->encoding = encoding_mode_from_string(mode_str);
+		if (options->encoding == encoding_none) {
+			return -1;
+		}
+	}
+
+	snprintf(path, sizeof(path), "$[%d].decimation.mode", i);
+	if (mjson_get_string(req->params, req->params_len, path, mode_str, sizeof(mode_str)) < 1) {
+		// no decimation requested
+		return 1;
+	}
+	snprintf(path, sizeof(path), "$[%d].decimation.factor", i);
+	options->decimation = decimation_mode_from_string(mode_str);
+	if (options->decimation == decimation_none || !mjson_get_number(req->params, req->params_len, path, &num) ||
+	    num < 2 || num > UINT32_MAX) {
+		return -1;
+	}
+	options->factor = (uint32_t)num;
+	return 1;
+}
+
 static void rpc_cb_subscribe(struct jsonrpc_request *req)
 {
 	char signal_id[STREAMING_SIGNAL_NAME_LENGTH];
-	char path[14];
+	subscribe_options_t options;
 	bool success = true;
 
-	for (int i = 0;;) {
-		snprintf(path, sizeof(path), "$[%d]", i++);
-		if (mjson_get_string(req->params, req->params_len, path, signal_id, sizeof(signal_id)) >= 1) {
-			success = signals_subscribe(req->userdata, signal_id) == 0;
+	for (int i = 0;; i++) {
+		int ret = rpc_get_subscribe_param(req, i, signal_id, sizeof(signal_id), &options);
+		if (ret < 0) {
+			success = false;
+			break;
+		} else if (ret > 0) {
+			success = signals_subscribe_with_options(req->userdata, signal_id, &options) == 0;
 		} else {
 			break;
 		}
@@ -74,6 +132,95 @@ static void rpc_cb_unsubscribe(struct jsonrpc_request *req)
 	}
 }
 
+/**
+ * reads an optional count of the trigger params, a missing count keeps its default
+ *
+ * @return 0 success, <0 not an integer between min and UINT32_MAX
+ */
+static int rpc_get_count(struct jsonrpc_request *req, const char *path, uint32_t min, uint32_t *count)
+{
+	double num;
+
+	if (mjson_find(req->params, req->params_len, path, NULL, NULL) == MJSON_TOK_INVALID) {
+		return 0;
+	}
+	if (!mjson_get_number(req->params, req->params_len, path, &num) || num < min || num > UINT32_MAX ||
+	    num != (uint32_t)num) {
+		return -1;
+	}
+	*count = (uint32_t)num;
+	return 0;
+}
+
+/**
+ * reads element i of the trigger params, e.g. {"signalId": "ai0", "mode": "rising", "level": 1.5, "pre": 100,
+ * "post": 1000}. Level, pre and post are optional and default to 0, 0 and 1.
+ *
+ * @return 1 element read, 0 no more elements, <0 invalid element
+ */
+static int rpc_get_trigger_param(struct jsonrpc_request *req, int i, trigger_t **trigger, trigger_config_t *config)
+{
+	char signal_id[STREAMING_SIGNAL_NAME_LENGTH];
+	char mode_str[10];
+	char path[24];
+
+	snprintf(path, sizeof(path), "$[%d].signalId", i);
+	if (mjson_get_string(req->params, req->params_len, path, signal_id, sizeof(signal_id)) < 1) {
+		return 0;
+	}
+	*trigger = triggers_find(signal_id);
+
+	snprintf(path, sizeof(path), "$[%d].mode", i);
+	if (*trigger == NULL || mjson_get_string(req->params, req->params_len, path, mode_str, sizeof(mode_str)) < 1) {
+		return -1;
+	}
+	config->mode = trigger_mode_from_string(mode_str);
+	if (config->mode == trigger_off && strcmp(mode_str, "off")) {
+		return -1;
+	}
+	snprintf(path, sizeof(path), "$[%d].level", i);
+	if (!mjson_get_number(req->params, req->params_len, path, &config->level)) {
+		config->level = 0;
+	}
+	config->pre = 0;
+	config->post = 1;
+	snprintf(path, sizeof(path), "$[%d].pre", i);
+	if (rpc_get_count(req, path, 0, &config->pre) < 0) {
+		return -1;
+	}
+	snprintf(path, sizeof(path), "$[%d].post", i);
+	if (rpc_get_count(req, path, 1, &config->post) < 0) {
+		return -1;
+	}
+	return streaming_trigger_config_valid(*trigger, config->pre, config->post) ? 1 : -1;
+}
+
+/**
+ * configures the trigger stages of explicit signals, mode "off" streams a signal continuously again. All elements
+ * are checked before the first one is applied, so an invalid request changes nothing.
+ */
+static void rpc_cb_trigger(struct jsonrpc_request *req)
+{
+	trigger_t *trigger;
+	trigger_config_t config;
+	int num = 0;
+	int ret;
+
+	while ((ret = rpc_get_trigger_param(req, num, &trigger, &config)) > 0) {
+		num++;
+	}
+	if (ret < 0) {
+		jsonrpc_return_error(req, -32602, "Invalid params", NULL);
+		return;
+	}
+
+	for (int i = 0; i < num; i++) {
+		rpc_get_trigger_param(req, i, &trigger, &config);
+		streaming_trigger_configure(trigger, config.mode, config.level, config.pre, config.post);
+	}
+	jsonrpc_return_success(req, "true");
+}
+
 static int streaming_jsonrpc_callback(void *pContext, WEBS_OUTPUT *pOutput, const char *sMethod, const char *sAccept,
                                       const char *sContentType, const char *sResource, U32 ContentLen)
 {
@@ -87,7 +234,7 @@ static int streaming_jsonrpc_callback(void *pContext, WEBS_OUTPUT *pOutput, cons
 	int len = IP_WEBS_METHOD_CopyData(pContext, buf, ContentLen < JSONRPC_BUF_SIZE ? ContentLen : JSONRPC_BUF_SIZE);
 	buf[len < 0 ? 0 : len] = '\0';
 	IP_WEBS_SendHeaderEx(pOutput, NULL, "application/json", 1);
-	jsonrpc_ctx_process(&ctx, buf, (len > 0) ? len : 0, rpc_sender, pOutput, &single_stream);
+	jsonrpc_ctx_process(&ctx, buf, (len > 0) ? len : 0, rpc_sender, pOutput, streaming_served_stream());
 	IP_WEBS_Flush(pOutput);
 	return 0;
 }
@@ -97,9 +244,12 @@ void streaming_jsonrpc_init(char stream_id[9])
 	jsonrpc_ctx_init(&ctx, NULL, NULL);
 	static char subscribe_method[19];
 	static char unsubscribe_method[21];
+	static char trigger_method[17];
 	snprintf(subscribe_method, sizeof(subscribe_method), "%s.subscribe", stream_id);
 	snprintf(unsubscribe_method, sizeof(unsubscribe_method), "%s.unsubscribe", stream_id);
+	snprintf(trigger_method, sizeof(trigger_method), "%s.trigger", stream_id);
 	jsonrpc_ctx_export(&ctx, subscribe_method, rpc_cb_subscribe);
 	jsonrpc_ctx_export(&ctx, unsubscribe_method, rpc_cb_unsubscribe);
+	jsonrpc_ctx_export(&ctx, trigger_method, rpc_cb_trigger);
 	IP_WEBS_METHOD_AddHook_SingleMethod(&streaming_hook, streaming_jsonrpc_callback, JSONRPC_PATH, JSONRPC_METHOD);
 }
@@ -17,8 +17,12 @@
 #include "streaming_meta.h"
 #include "mpack.h"
 #include "streaming_config.h"
+#include "streaming_decimation.h"
+#include "streaming_encoding.h"
 #include "streaming_packet.h"
+#include "streaming_quantization.h"
 #include "streaming_signals.h"
+#include "streaming_struct.h"
 
 static int mpack_write_finally(mpack_writer_t *w)
 {
@@ -86,6 +90,13 @@ static const char *signal_data_type_to_string(signal_data_type_e datatype)
 		return "complex32";
 	case signal_type_complex64:
 		return "complex64";
+	case signal_type_bitfield8:
+	case signal_type_bitfield16:
+	case signal_type_bitfield32:
+	case signal_type_bitfield64:
+		return "bitField";
+	case signal_type_struct:
+		return "struct";
 	}
 	return "unknown";
 }
@@ -136,14 +147,185 @@ static void build_mpack_meta_signal_time_opendaq(mpack_writer_t *w, const time_o
 	mpack_finish_map(w);
 }
 
-static void build_mpack_meta_signal_definition(mpack_writer_t *w, signal_definition_t *def)
+/**
+ * input samples per transmitted sample of the table of signal, 1 if its value signals are not decimated
+ */
+static uint64_t signal_domain_factor(signal_t *signal)
+{
+	return signal->table != NULL && signal->table->domain_factor > 1 ? signal->table->domain_factor : 1;
+}
+
+static void build_mpack_meta_signal_decimation(mpack_writer_t *w, const decimation_t *decimation)
+{
+	// informative only, the rate of the samples is given by the scaled delta of the linear domain signal
+	mpack_write_cstr(w, META_DECIMATION);
+	mpack_start_map(w, 2);
+	mpack_write_cstr(w, "mode");
+	mpack_write_cstr(w, decimation_mode_to_string(decimation->mode));
+	mpack_write_cstr(w, "factor");
+	mpack_write_u32(w, decimation->factor);
+	mpack_finish_map(w);
+}
+
+/**
+ * the word holding the bits is advertised as unsigned integer of the same width
+ */
+static signal_data_type_e bitfield_word_type(signal_data_type_e datatype)
+{
+	switch (datatype) {
+	case signal_type_bitfield8:
+		return signal_type_uint8;
+	case signal_type_bitfield16:
+		return signal_type_uint16;
+	case signal_type_bitfield32:
+		return signal_type_uint32;
+	default:
+		return signal_type_uint64;
+	}
+}
+
+static void build_mpack_meta_signal_bitfield(mpack_writer_t *w, signal_definition_t *def)
+{
+	const bitfield_object_t *bitfield = def->bitfield;
+	uint32_t num_named = 0;
+
+	for (unsigned int i = 0; i < bitfield->num_bits; i++) {
+		if (bitfield->bits[i] != NULL) {
+			num_named++;
+		}
+	}
+
+	mpack_write_cstr(w, "bitField");
+	mpack_start_map(w, 2);
+	mpack_write_cstr(w, "dataType");
+	mpack_write_cstr(w, signal_data_type_to_string(bitfield_word_type(def->datatype)));
+	mpack_write_cstr(w, "bits");
+	mpack_start_array(w, num_named);
+	for (unsigned int i = 0; i < bitfield->num_bits; i++) {
+		if (bitfield->bits[i] == NULL) {
+			continue;
+		}
+		mpack_start_map(w, 2);
+		mpack_write_cstr(w, "index");
+		mpack_write_u32(w, i);
+		mpack_write_cstr(w, "description");
+		mpack_write_cstr(w, bitfield->bits[i]);
+		mpack_finish_map(w);
+	}
+	mpack_finish_array(w);
+	mpack_finish_map(w);
+}
+
+/**
+ * the fields of a record follow each other on the wire in the order they are listed
+ */
+static void build_mpack_meta_signal_struct(mpack_writer_t *w, const struct_object_t *structure)
+{
+	mpack_write_cstr(w, "struct");
+	mpack_start_array(w, structure->num_fields);
+	for (unsigned int i = 0; i < structure->num_fields; i++) {
+		mpack_start_map(w, 2);
+		mpack_write_cstr(w, "name");
+		mpack_write_cstr(w, structure->fields[i].name);
+		mpack_write_cstr(w, "dataType");
+		mpack_write_cstr(w, signal_data_type_to_string(structure->fields[i].datatype));
+		mpack_finish_map(w);
+	}
+	mpack_finish_array(w);
+}
+
+/**
+ * the linear domain of a spectrum signal is the frequency of the bins
+ *
+ * @return the spectrum object of the table of the domain signal, NULL if signal is not a frequency domain
+ */
+static const spectrum_object_t *frequency_domain(signal_t *signal)
+{
+	signal_definition_t *def = signal->definition;
+
+	if (def->rule != signal_linear_rule || def->signaltype != signal_type_time || signal->table == NULL) {
+		return NULL;
+	}
+	for (unsigned int i = 0; i < signal->table->signal_counter; i++) {
+		const spectrum_object_t *spectrum = signal->table->signals[i].definition->spectrum;
+		if (spectrum != NULL && spectrum->size > 0) {
+			return spectrum;
+		}
+	}
+	return NULL;
+}
+
+static void build_mpack_meta_signal_frequency_unit(mpack_writer_t *w)
+{
+	mpack_write_cstr(w, "unit");
+	mpack_start_map(w, 3);
+	mpack_write_cstr(w, "displayName");
+	mpack_write_cstr(w, "Hz");
+	mpack_write_cstr(w, "unitId");
+	mpack_write_int(w, 4740186); // hertz
+	mpack_write_cstr(w, "quantity");
+	mpack_write_cstr(w, "frequency");
+	mpack_finish_map(w);
+}
+
+static void build_mpack_meta_signal_range(mpack_writer_t *w, double low, double high)
+{
+	mpack_write_cstr(w, "range");
+	mpack_start_map(w, 2);
+	mpack_write_cstr(w, "low");
+	mpack_write_double(w, low);
+	mpack_write_cstr(w, "high");
+	mpack_write_double(w, high);
+	mpack_finish_map(w);
+}
+
+static void build_mpack_meta_signal_postScaling(mpack_writer_t *w, double offset, double scale)
 {
+	mpack_write_cstr(w, "postScaling");
+	mpack_start_map(w, 2);
+	mpack_write_cstr(w, "offset");
+	mpack_write_double(w, offset);
+	mpack_write_cstr(w, "scale");
+	mpack_write_double(w, scale);
+	mpack_finish_map(w);
+}
+
+/**
+ * range and postScaling of a quantized signal refer to the integer samples on the wire. The quantization
+ * is composed with the postScaling of the signal definition, if any.
+ */
+static void build_mpack_meta_signal_quantization(mpack_writer_t *w, signal_definition_t *def)
+{
+	double limit = quantization_limit(def);
+	double scale;
+	double offset;
+
+	quantization_params(def, &scale, &offset);
+	if (def->postScaling != NULL) {
+		offset = offset * def->postScaling->scale + def->postScaling->offset;
+		scale *= def->postScaling->scale;
+	}
+	build_mpack_meta_signal_range(w, -limit, limit);
+	build_mpack_meta_signal_postScaling(w, offset, scale);
+}
+
+static void build_mpack_meta_signal_definition(mpack_writer_t *w, signal_t *signal)
+{
+	signal_definition_t *def = signal->definition;
+	const decimation_t *decimation = &signal->decimation;
 	// at least name, ruleType and dataType have to be present
 	uint8_t definition_map_elements = 3;
 	bool is_linear_rule = def->rule == signal_linear_rule;
-	bool is_time_signal = def->time != NULL;
+	// a frequency domain has a unit of its own instead of the time resolution
+	const spectrum_object_t *frequency = frequency_domain(signal);
+	bool is_time_signal = def->time != NULL && frequency == NULL;
+	bool is_quantized = quantization_active(def);
 	bool has_range = def->range != NULL;
-	bool has_postScaling = def->postScaling != NULL;
+	bool has_postScaling = def->postScaling != NULL || is_quantized;
+	bool is_decimated = decimation_active(decimation);
+	bool is_encoded = signal->encoding != encoding_none;
+	bool is_bitfield = def->bitfield != NULL && signal_data_type_is_bitfield(def->datatype);
+	bool is_struct = struct_valid(def);
 	
 	if (is_time_signal) {
 		definition_map_elements += 3; // only with build_mpack_meta_signal_time_opendaq
@@ -160,6 +342,26 @@ static void build_mpack_meta_signal_definition(mpack_writer_t *w, signal_definit
 	if (has_postScaling) {
 		definition_map_elements++;
 	}
+
+	if (is_decimated) {
+		definition_map_elements++;
+	}
+
+	if (is_encoded) {
+		definition_map_elements++;
+	}
+
+	if (is_bitfield) {
+		definition_map_elements++;
+	}
+
+	if (is_struct) {
+		definition_map_elements++;
+	}
+
+	if (frequency != NULL) {
+		definition_map_elements++;
+	}
 	
 	mpack_start_map(w, definition_map_elements);
 	mpack_write_cstr(w, "name");
@@ -167,12 +369,23 @@ static void build_mpack_meta_signal_definition(mpack_writer_t *w, signal_definit
 	mpack_write_cstr(w, "rule");
 	mpack_write_cstr(w, signal_rule_to_string(def->rule));
 	mpack_write_cstr(w, "dataType");
-	mpack_write_cstr(w, signal_data_type_to_string(def->datatype));
+	if (signal_data_type_is_bitfield(def->datatype) && !is_bitfield) {
+		// without a bitfield object to describe the bits, the words are plain unsigned integers
+		mpack_write_cstr(w, signal_data_type_to_string(bitfield_word_type(def->datatype)));
+	} else {
+		mpack_write_cstr(w, signal_data_type_to_string(signal_wire_datatype(def)));
+	}
 	if (is_linear_rule) {
 		mpack_write_cstr(w, "linear");
 		mpack_start_map(w, 1);
 		mpack_write_cstr(w, "delta");
-		mpack_write_u64(w, def->delta);
+		if (frequency != NULL) {
+			// the bins of a spectrum are resolution Hz apart
+			mpack_write_double(w, frequency->sampleRate / frequency->size * signal_domain_factor(signal));
+		} else {
+			// decimated value signals of the table are sent at a lower rate
+			mpack_write_u64(w, def->delta * signal_domain_factor(signal));
+		}
 		mpack_finish_map(w);
 	}
 	if (is_time_signal) {
@@ -180,24 +393,37 @@ static void build_mpack_meta_signal_definition(mpack_writer_t *w, signal_definit
 		// build_mpack_meta_signal_time(w, def->time);
 	}
 
-	if (has_range) {
-		mpack_write_cstr(w, "range");
-		mpack_start_map(w, 2);
-		mpack_write_cstr(w, "low");
-		mpack_write_double(w, def->range->low);
-		mpack_write_cstr(w, "high");
-		mpack_write_double(w, def->range->high);
-		mpack_finish_map(w);
+	if (is_quantized) {
+		build_mpack_meta_signal_quantization(w, def);
+	} else {
+		if (has_range) {
+			build_mpack_meta_signal_range(w, def->range->low, def->range->high);
+		}
+		if (has_postScaling) {
+			build_mpack_meta_signal_postScaling(w, def->postScaling->offset, def->postScaling->scale);
+		}
 	}
 
-	if (has_postScaling) {
-		mpack_write_cstr(w, "postScaling");
-		mpack_start_map(w, 2);
-		mpack_write_cstr(w, "offset");
-		mpack_write_double(w, def->postScaling->offset);
-		mpack_write_cstr(w, "scale");
-		mpack_write_double(w, def->postScaling->scale);
-		mpack_finish_map(w);
+	if (is_decimated) {
+		build_mpack_meta_signal_decimation(w, decimation);
+	}
+
+	if (is_bitfield) {
+		build_mpack_meta_signal_bitfield(w, def);
+	}
+
+	if (is_struct) {
+		build_mpack_meta_signal_struct(w, def->structure);
+	}
+
+	if (frequency != NULL) {
+		build_mpack_meta_signal_frequency_unit(w);
+	}
+
+	if (is_encoded) {
+		// the payload of the data packets holds the encoded samples of dataType
+		mpack_write_cstr(w, META_ENCODING);
+		mpack_write_cstr(w, encoding_mode_to_string(signal->encoding));
 	}
 	
 	mpack_finish_map(w);
@@ -218,6 +444,10 @@ static int count_related_signals(signal_t *signal)
 int build_mpack_meta_signal(char *dst, int size, signal_t *signal, uint64_t valueIndex)
 {
 	mpack_writer_t writer;
+	if (valueIndex != 0) {
+		// the value index counts transmitted samples
+		valueIndex = signal_wire_index(signal, valueIndex);
+	}
 	mpack_writer_init(&writer, dst, size);
 	mpack_start_map(&writer, 2);
 	mpack_write_cstr(&writer, MPACK_KEY_METHOD);
@@ -245,7 +475,7 @@ int build_mpack_meta_signal(char *dst, int size, signal_t *signal, uint64_t valu
 	}
 	mpack_finish_array(&writer);
 	mpack_write_cstr(&writer, "definition");
-	build_mpack_meta_signal_definition(&writer, signal->definition);
+	build_mpack_meta_signal_definition(&writer, signal);
 	mpack_finish_map(&writer);
 	mpack_finish_map(&writer);
 	return mpack_write_finally(&writer);
@@ -266,7 +496,13 @@ int build_mpack_meta_stream_init(char *dst, int size, const char *id)
 	mpack_write_cstr(&writer, id);
 
 	mpack_write_cstr(&writer, "supported");
-	mpack_start_map(&writer, 0);
+	mpack_start_map(&writer, 1);
+	// payload encodings a client may request when subscribing
+	mpack_write_cstr(&writer, META_ENCODINGS);
+	mpack_start_array(&writer, 2);
+	mpack_write_cstr(&writer, encoding_mode_to_string(encoding_delta_varint));
+	mpack_write_cstr(&writer, encoding_mode_to_string(encoding_frame_of_reference));
+	mpack_finish_array(&writer);
 	mpack_finish_map(&writer);
 
 	mpack_write_cstr(&writer, "commandInterfaces");
@@ -311,6 +547,25 @@ int build_mpack_meta_stream_version(char *dst, int size)
 	return mpack_write_finally(&writer);
 }
 
+/**
+ * percentage of the congestion limits of the stream in use, 0 to 100
+ */
+int build_mpack_meta_stream_fill_level(char *dst, int size, uint8_t fill_level)
+{
+	mpack_writer_t writer;
+	mpack_writer_init(&writer, dst, size);
+	mpack_start_map(&writer, 2);
+	mpack_write_cstr(&writer, MPACK_KEY_METHOD);
+	mpack_write_cstr(&writer, META_FILLLEVEL);
+	mpack_write_cstr(&writer, MPACK_KEY_PARAMS);
+	mpack_start_map(&writer, 1);
+	mpack_write_cstr(&writer, META_FILLLEVEL);
+	mpack_write_u8(&writer, fill_level);
+	mpack_finish_map(&writer);
+	mpack_finish_map(&writer);
+	return mpack_write_finally(&writer);
+}
+
 int build_mpack_meta_signal_subscribed(char *dst, int size, const char *id)
 {
 	mpack_writer_t writer;
@@ -14,6 +14,7 @@ int build_mpack_meta_stream_avail(char *dst, int size, signal_t **signals, int n
 int build_mpack_meta_stream_unavail(char *dst, int size, signal_t **signals, int num_signals);
 int build_mpack_meta_stream_version(char *dst, int size);
 int build_mpack_meta_stream_init(char *dst, int size, const char *id);
+int build_mpack_meta_stream_fill_level(char *dst, int size, uint8_t fill_level);
 
 #define MPACK_KEY_METHOD "method"
 #define MPACK_KEY_PARAMS "params"
@@ -49,6 +50,10 @@ int build_mpack_meta_stream_init(char *dst, int size, const char *id);
 #define META_RULETYPE_CONSTANT "constant"
 #define META_NAME "name"
 
+#define META_DECIMATION "decimation"
+#define META_ENCODING "encoding"
+#define META_ENCODINGS "encodings"
+
 #define META_FILLLEVEL "fillLevel"
 #define META_START "start"
 #define META_DELTA "delta"
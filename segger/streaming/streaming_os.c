@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "streaming_os.h"
+
+#if STREAMING_HOST_BUILD
+
+	#include <errno.h>
+	#include <time.h>
+
+uint32_t streaming_os_time_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+uint64_t streaming_os_time_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void streaming_os_sleep_until_us(uint64_t time_us)
+{
+	struct timespec ts = {
+	    .tv_sec = (time_t)(time_us / 1000000),
+	    .tv_nsec = (long)(time_us % 1000000) * 1000,
+	};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+		// interrupted by a signal
+	}
+}
+
+void streaming_mutex_init(streaming_mutex_t *mutex)
+{
+	pthread_mutex_init(mutex, NULL);
+}
+
+void streaming_mutex_lock(streaming_mutex_t *mutex)
+{
+	pthread_mutex_lock(mutex);
+}
+
+void streaming_mutex_unlock(streaming_mutex_t *mutex)
+{
+	pthread_mutex_unlock(mutex);
+}
+
+void streaming_wakeup_init(streaming_wakeup_t *wakeup)
+{
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&wakeup->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	pthread_mutex_init(&wakeup->mutex, NULL);
+	wakeup->pending = false;
+}
+
+void streaming_wakeup_signal(streaming_wakeup_t *wakeup)
+{
+	pthread_mutex_lock(&wakeup->mutex);
+	wakeup->pending = true;
+	pthread_cond_signal(&wakeup->cond);
+	pthread_mutex_unlock(&wakeup->mutex);
+}
+
+bool streaming_wakeup_wait(streaming_wakeup_t *wakeup, uint32_t timeout_ms)
+{
+	struct timespec until;
+	int ret = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &until);
+	until.tv_sec += timeout_ms / 1000;
+	until.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+	if (until.tv_nsec >= 1000000000) {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&wakeup->mutex);
+	while (!wakeup->pending && ret == 0) {
+		if (timeout_ms == STREAMING_WAIT_FOREVER) {
+			ret = pthread_cond_wait(&wakeup->cond, &wakeup->mutex);
+		} else {
+			ret = pthread_cond_timedwait(&wakeup->cond, &wakeup->mutex, &until);
+		}
+	}
+	bool woken = wakeup->pending;
+	wakeup->pending = false;
+	pthread_mutex_unlock(&wakeup->mutex);
+	return woken;
+}
+
+#else
+
+/**
+ * length of the system tick in microseconds, the tick is configured by the board support package
+ */
+static uint32_t tick_us(void)
+{
+	uint32_t us = OS_TIME_ConvertTicks2us(1);
+	return us > 0 ? us : 1;
+}
+
+uint32_t streaming_os_time_ms(void)
+{
+	return (uint32_t)(OS_TIME_Getus64() / 1000);
+}
+
+uint64_t streaming_os_time_us(void)
+{
+	return OS_TIME_Getus64();
+}
+
+void streaming_os_sleep_until_us(uint64_t time_us)
+{
+	uint32_t tick = tick_us();
+
+	// OS_TIME_Getus64 counts from tick 0, the wakeup is the first tick at or after time_us
+	OS_TASK_DelayUntil((OS_TIME)((time_us + tick - 1) / tick));
+}
+
+void streaming_mutex_init(streaming_mutex_t *mutex)
+{
+	OS_MUTEX_Create(mutex);
+}
+
+void streaming_mutex_lock(streaming_mutex_t *mutex)
+{
+	OS_MUTEX_LockBlocked(mutex);
+}
+
+void streaming_mutex_unlock(streaming_mutex_t *mutex)
+{
+	OS_MUTEX_Unlock(mutex);
+}
+
+void streaming_wakeup_init(streaming_wakeup_t *wakeup)
+{
+	OS_SEMAPHORE_Create(wakeup, 0);
+}
+
+void streaming_wakeup_signal(streaming_wakeup_t *wakeup)
+{
+	OS_SEMAPHORE_Give(wakeup);
+}
+
+bool streaming_wakeup_wait(streaming_wakeup_t *wakeup, uint32_t timeout_ms)
+{
+	if (timeout_ms == STREAMING_WAIT_FOREVER) {
+		OS_SEMAPHORE_TakeBlocked(wakeup);
+		return true;
+	}
+	OS_TIME ticks = OS_TIME_Convertms2Ticks(timeout_ms);
+	// a timeout of 0 ticks would wait forever
+	return OS_SEMAPHORE_TakeTimed(wakeup, ticks > 0 ? ticks : 1) != 0;
+}
+
+#endif
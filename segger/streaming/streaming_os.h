@@ -0,0 +1,75 @@
+#ifndef _STREAMING_OS_H_
+#define _STREAMING_OS_H_
+
+#include "streaming_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * the few operating system services the timing code of the library needs. On the target they map to embOS,
+ * with STREAMING_HOST_BUILD they map to POSIX threads, so the same code can be tuned on a host.
+ */
+
+#if STREAMING_HOST_BUILD
+	#include <pthread.h>
+
+typedef pthread_mutex_t streaming_mutex_t;
+
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool pending;
+} streaming_wakeup_t;
+#else
+	#include "RTOS.h"
+
+typedef OS_MUTEX streaming_mutex_t;
+typedef OS_SEMAPHORE streaming_wakeup_t;
+#endif
+
+/**
+ * held while a packet is sent through a stream, so header and payload of a packet are not interleaved with
+ * the packets of other tasks
+ */
+struct stream_lock {
+	streaming_mutex_t mutex;
+};
+
+// waits without a timeout
+#define STREAMING_WAIT_FOREVER UINT32_MAX
+
+/**
+ * monotonic time in milliseconds, wraps around. On embOS it is independent of the length of the system tick.
+ */
+uint32_t streaming_os_time_ms(void);
+
+/**
+ * monotonic time in microseconds, for statistics
+ */
+uint64_t streaming_os_time_us(void);
+
+/**
+ * sleeps until streaming_os_time_us reaches time_us. On embOS the wakeup is the first system tick at or after
+ * time_us, so a period that is a multiple of the tick stays aligned to the OS timer.
+ */
+void streaming_os_sleep_until_us(uint64_t time_us);
+
+void streaming_mutex_init(streaming_mutex_t *mutex);
+void streaming_mutex_lock(streaming_mutex_t *mutex);
+void streaming_mutex_unlock(streaming_mutex_t *mutex);
+
+/**
+ * a wakeup lets one task sleep until another task wakes it up or a timeout expires. Wakeups while nobody
+ * waits are remembered, the next wait returns immediately.
+ */
+void streaming_wakeup_init(streaming_wakeup_t *wakeup);
+void streaming_wakeup_signal(streaming_wakeup_t *wakeup);
+
+/**
+ * @param timeout_ms maximum time to wait, STREAMING_WAIT_FOREVER for no timeout
+ *
+ * @return true if woken up, false on timeout
+ */
+bool streaming_wakeup_wait(streaming_wakeup_t *wakeup, uint32_t timeout_ms);
+
+#endif
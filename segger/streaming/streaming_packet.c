@@ -18,8 +18,15 @@
 #include "IP_WEBSOCKET.h"
 #include "SEGGER_UTIL.h"
 #include "mpack.h"
+#include "streaming_congestion.h"
+#include "streaming_decimation.h"
+#include "streaming_endian.h"
+#include "streaming_os.h"
+#include "streaming_quantization.h"
 #include "streaming_signals.h"
+#include "streaming_struct.h"
 #include <stdint.h>
+#include <string.h>
 
 #define METAINFORMATION_MSGPACK (2)
 
@@ -34,56 +41,88 @@ static void build_packet_meta(tl_packet_t *packet, uint32_t signal_no, char *mpa
 static int tl_serialize_packet(tl_packet_t *packet, unsigned char *dst, size_t buff_size);
 
 /**
- * this function serializes the streaming transport layer header as well as the websocket header
- *
- * In a clean architecture both would be handled seperatly. However, when we serilize the streaming packet
- * we cannot tell how much pre-space we should leave in the destination buffer, because the size
- * of the websocket header varies, and the size of the streaming header varies as well. For the sake of usability
- * we allow ourselves this design choice, as it enables serializing consecutive packets in the same buffer.
- *
- * @param packet: the packet to serialize its header
- * @param dst: destination buffer
- * @param buff_size: size of the buffer in bytes
- * @return: <0     error: e.g. buffer too small
-            else   number of bytes written
+ * the streaming transport layer header size depends on the payload size
  */
-static int serialize_header(tl_packet_t *packet, unsigned char *dst, size_t buff_size)
+static inline size_t tl_header_size(uint32_t payload_size)
 {
-	const uint32_t signal_no = SIGNAL_NUMBER_MASK & (packet->signal_number << SIGNAL_NUMBER_SHIFT);
-	const uint32_t packet_type = TYPE_MASK & (packet->packet_type << TYPE_SHIFT);
-	const uint32_t size = SIZE_MASK & (packet->payload_size << SIZE_SHIFT);
+	return payload_size > UINT8_MAX ? 8 : 4;
+}
 
-	// first calculate the required header sizes
-	// the streaming header size depends on the payload size
-	size_t tl_header_size = (packet->payload_size) > UINT8_MAX ? 8 : 4;
+/**
+ * size of a websocket header in front of a websocket payload of websocket_payload_size bytes
+ */
+static inline size_t websocket_length_header_size(size_t websocket_payload_size)
+{
+	if (websocket_payload_size < 126) {
+		return 2;
+	}
+	return websocket_payload_size <= UINT16_MAX ? 4 : 10;
+}
 
+/**
+ * the websocket header size depends on the size of its payload, which contains the streaming header
+ */
+static inline size_t websocket_header_size(uint32_t payload_size)
+{
 #ifdef WEBSOCKET_STREAMING
-	// the websocket header size depends on the size of its payload, which contains the streaming header
-	size_t websocket_payload_size = tl_header_size + packet->payload_size;
-	size_t websocket_header_size = websocket_payload_size < 126 ? 2 : 4;
-	size_t header_size = websocket_header_size + tl_header_size;
+	return websocket_length_header_size(tl_header_size(payload_size) + payload_size);
 #else
-	size_t header_size = tl_header_size;
+	(void)payload_size;
+	return 0;
 #endif
+}
 
-	if (buff_size < header_size) {
-		// not enough space for the header
-		return -1;
-	}
+/**
+ * size of all headers in front of a payload of payload_size bytes
+ */
+static inline size_t packet_header_size(uint32_t payload_size)
+{
+	return websocket_header_size(payload_size) + tl_header_size(payload_size);
+}
 
 #ifdef WEBSOCKET_STREAMING
-	// serialize the websocket header
+/**
+ * serializes the header of an unmasked binary websocket frame
+ *
+ * @param dst: destination buffer, must hold websocket_length_header_size(websocket_payload_size) bytes
+ * @param websocket_payload_size: number of bytes following the header in this frame
+ * @return: number of bytes written
+ */
+static size_t serialize_websocket_header(unsigned char *dst, size_t websocket_payload_size)
+{
+	size_t header_size = websocket_length_header_size(websocket_payload_size);
+
 	*dst++ = 0x80 + IP_WEBSOCKET_FRAME_TYPE_BINARY; // FIN and binary packet
 	if (websocket_payload_size < 126) {
 		*dst++ = websocket_payload_size; // no mask bit set
-	} else {
+	} else if (websocket_payload_size <= UINT16_MAX) {
 		*dst++ = 126; // no mask bit set
 		*dst++ = websocket_payload_size >> 8;
 		*dst++ = websocket_payload_size & 0xff;
+	} else {
+		// 64 bit extended payload length in network byte order
+		*dst++ = 127; // no mask bit set
+		for (int shift = 56; shift >= 0; shift -= 8) {
+			*dst++ = ((uint64_t)websocket_payload_size >> shift) & 0xff;
+		}
 	}
+	return header_size;
+}
 #endif
 
-	// serialize the streaming header
+/**
+ * serializes the streaming transport layer header
+ *
+ * @param packet: the packet to serialize its header
+ * @param dst: destination buffer, must hold tl_header_size(packet->payload_size) bytes
+ * @return: number of bytes written
+ */
+static size_t serialize_tl_header(tl_packet_t *packet, unsigned char *dst)
+{
+	const uint32_t signal_no = SIGNAL_NUMBER_MASK & (packet->signal_number << SIGNAL_NUMBER_SHIFT);
+	const uint32_t packet_type = TYPE_MASK & (packet->packet_type << TYPE_SHIFT);
+	const uint32_t size = SIZE_MASK & (packet->payload_size << SIZE_SHIFT);
+
 	// if payload-size is >255 Bytes, size in header needs to be 0,
 	// so that payload_size gets serialized as data_byte_count
 	if (packet->payload_size > UINT8_MAX) {
@@ -92,121 +131,194 @@ static int serialize_header(tl_packet_t *packet, unsigned char *dst, size_t buff
 	} else {
 		SEGGER_WrU32LE(dst, signal_no | packet_type | size);
 	}
+	return tl_header_size(packet->payload_size);
+}
 
-	// return the number of bytes written
+/**
+ * writes the websocket header and the streaming transport layer header without checking the buffer size
+ *
+ * @param packet: the packet to serialize its header
+ * @param dst: destination buffer, must hold packet_header_size(packet->payload_size) bytes
+ * @return: number of bytes written
+ */
+static size_t write_header(tl_packet_t *packet, unsigned char *dst)
+{
+	size_t header_size = 0;
+#ifdef WEBSOCKET_STREAMING
+	header_size += serialize_websocket_header(dst, tl_header_size(packet->payload_size) + packet->payload_size);
+#endif
+	header_size += serialize_tl_header(packet, dst + header_size);
 	return header_size;
 }
 
-int openDAQ_streaming_send_packet(const struct stream *stream, tl_packet_t *packet)
+/**
+ * this function serializes the streaming transport layer header as well as the websocket header
+ *
+ * In a clean architecture both would be handled seperatly. However, when we serilize the streaming packet
+ * we cannot tell how much pre-space we should leave in the destination buffer, because the size
+ * of the websocket header varies, and the size of the streaming header varies as well. For the sake of usability
+ * we allow ourselves this design choice, as it enables serializing consecutive packets in the same buffer.
+ *
+ * @param packet: the packet to serialize its header
+ * @param dst: destination buffer
+ * @param buff_size: size of the buffer in bytes
+ * @return: <0     error: e.g. buffer too small
+            else   number of bytes written
+ */
+static int serialize_header(tl_packet_t *packet, unsigned char *dst, size_t buff_size)
 {
-	char buff[packet->payload_size + 16]; // 16 bytes should be enough for all headers
-	int packet_size = tl_serialize_packet(packet, (unsigned char *)buff, sizeof(buff));
+	if (buff_size < packet_header_size(packet->payload_size)) {
+		// not enough space for the header
+		return -1;
+	}
 
-	return packet_size < 0 ? packet_size : stream->stream(stream, buff, packet_size);
+	// return the number of bytes written
+	return write_header(packet, dst);
 }
 
 /**
- * copies from src to dst and swaps to little endian
+ * size in bytes of one explicit sample at the source, which is the default stride
  */
-static inline void openDAQ_copy_sample_le(signal_data_type_e datatype, unsigned char *dst, const void *src)
+static inline size_t source_sample_size(signal_definition_t *def)
 {
-	switch (datatype) {
-	case signal_type_int8:
-	case signal_type_uint8:
-		*dst = *(const U8 *)src;
-		break;
-	case signal_type_int16:
-	case signal_type_uint16:
-		SEGGER_WrU16LE(dst, *(const U16 *)src);
-		break;
-	case signal_type_int32:
-	case signal_type_uint32:
-	case signal_type_real32:
-		SEGGER_WrU32LE(dst, *(const U32 *)src);
-		break;
-	case signal_type_int64:
-	case signal_type_uint64:
-	case signal_type_real64:
-		SEGGER_WrU64LE(dst, *(const U64 *)src);
-		break;
-	case signal_type_complex32:
-		const U32 *ptr32 = (const U32 *)src;
-		SEGGER_WrU32LE(dst, *ptr32++);
-		SEGGER_WrU32LE(dst + sizeof(U32), *ptr32++);
-		break;
-	case signal_type_complex64:
-		const U64 *ptr64 = (const U64 *)src;
-		SEGGER_WrU64LE(dst, *ptr64++);
-		SEGGER_WrU64LE(dst + sizeof(U64), *ptr64++);
-		break;
-	case signal_type_int128:
-	case signal_type_uint128:
-		// TODO
-		break;
-	default:
-		break;
+	if (def->datatype == signal_type_struct) {
+		return struct_valid(def) ? def->structure->record_size : 0;
 	}
+	return openDAQ_get_sample_size(def->datatype);
 }
 
-static inline int openDAQ_get_sample_size(signal_data_type_e datatype)
-{
-	switch (datatype) {
-	case signal_type_int8:
-	case signal_type_uint8:
-		return sizeof(U8);
-	case signal_type_int16:
-	case signal_type_uint16:
-		return sizeof(U16);
-	case signal_type_int32:
-	case signal_type_uint32:
-	case signal_type_real32:
-		return sizeof(U32);
-	case signal_type_int64:
-	case signal_type_uint64:
-	case signal_type_real64:
-		return sizeof(U64);
-	case signal_type_complex32:
-		return sizeof(U32) * 2;
-	case signal_type_complex64:
-		return sizeof(U64) * 2;
-	case signal_type_int128:
-	case signal_type_uint128:
-		return 16;
+/**
+ * size in bytes of one explicit sample on the wire
+ */
+static inline size_t wire_sample_size(signal_definition_t *def)
+{
+	if (def->datatype == signal_type_struct) {
+		return struct_valid(def) ? struct_wire_size(def->structure) : 0;
 	}
-	return 0;
+	return openDAQ_get_sample_size(signal_wire_datatype(def));
 }
 
 /**
- * copies from src to dst and swaps to little endian. bytecount bytes are copied.
+ * converts num samples at src, which are stride bytes apart, to the datatype and byte order on the wire
  */
-static inline void memcpy_le(void *dst, const void *src, signal_data_type_e type, unsigned int bytecount)
+static inline void convert_explicit_samples(signal_definition_t *def, unsigned char *dst, const unsigned char *src,
+                                            size_t stride, size_t num)
 {
-	unsigned char *dst_ptr = dst;
-	const unsigned char *src_ptr = src;
-	size_t sample_size = openDAQ_get_sample_size(type);
+	if (def->datatype == signal_type_struct) {
+		struct_copy_records(def->structure, dst, src, stride, num);
+	} else if (quantization_active(def)) {
+		quantization_run(def, dst, src, stride, num);
+	} else {
+		streaming_copy_samples_le_strided(def->datatype, dst, openDAQ_get_sample_size(def->datatype), src, stride,
+		                                  num);
+	}
+}
+
+/**
+ * copies num samples, starting with sample first, of an explicit payload to dst in little endian byte order.
+ * The samples may be strided and may wrap around the end of a ring buffer.
+ */
+static void copy_explicit_samples(unsigned char *dst, pl_data_t *data, size_t first, size_t num)
+{
+	signal_definition_t *def = data->signal_defintion;
+	size_t wire_size = wire_sample_size(def);
+	size_t stride = data->stride ? data->stride : source_sample_size(def);
+	size_t before_wrap = data->src_wrap ? data->num_before_wrap : SIZE_MAX;
+	const unsigned char *src = data->src;
+
+	if (first < before_wrap) {
+		size_t n = num < before_wrap - first ? num : before_wrap - first;
+		convert_explicit_samples(def, dst, src + first * stride, stride, n);
+		dst += n * wire_size;
+		first += n;
+		num -= n;
+	}
+	if (num > 0) {
+		src = data->src_wrap;
+		convert_explicit_samples(def, dst, src + (first - before_wrap) * stride, stride, num);
+	}
+}
+
+/**
+ * encodes num samples, starting with sample first, of an explicit payload to dst. Like copy_explicit_samples
+ * the samples may be strided and may wrap around the end of a ring buffer.
+ *
+ * @return number of bytes written
+ */
+static size_t encode_explicit_samples(unsigned char *dst, pl_data_t *data, size_t first, size_t num)
+{
+	size_t sample_size = openDAQ_get_sample_size(data->signal_defintion->datatype);
+	size_t stride = data->stride ? data->stride : sample_size;
+	size_t before_wrap = data->src_wrap ? data->num_before_wrap : SIZE_MAX;
+	const unsigned char *src = data->src;
+	size_t len = 0;
+
+	if (first < before_wrap) {
+		size_t n = num < before_wrap - first ? num : before_wrap - first;
+		len += encoding_write(&data->encoding, dst, src + first * stride, stride, n);
+		first += n;
+		num -= n;
+	}
+	if (num > 0) {
+		src = data->src_wrap;
+		len += encoding_write(&data->encoding, dst + len, src + (first - before_wrap) * stride, stride, num);
+	}
+	return len;
+}
+
+/**
+ * decimates num samples, starting with input sample first, of an explicit payload to dst. Like
+ * copy_explicit_samples the samples may be strided and may wrap around the end of a ring buffer.
+ *
+ * @return number of bytes written
+ */
+static size_t decimate_explicit_samples(unsigned char *dst, pl_data_t *data, size_t first, size_t num)
+{
+	signal_data_type_e datatype = data->signal_defintion->datatype;
+	size_t sample_size = openDAQ_get_sample_size(datatype);
+	size_t stride = data->stride ? data->stride : sample_size;
+	size_t before_wrap = data->src_wrap ? data->num_before_wrap : SIZE_MAX;
+	const unsigned char *src = data->src;
+	size_t len = 0;
 
-	for (unsigned int i = 0; i < bytecount; i += sample_size) {
-		// copy sample for sample and swap to little endian
-		openDAQ_copy_sample_le(type, dst_ptr, src_ptr);
-		src_ptr += sample_size;
-		dst_ptr += sample_size;
+	if (first < before_wrap) {
+		size_t n = num < before_wrap - first ? num : before_wrap - first;
+		len += decimation_run(data->decimation, datatype, dst, src + first * stride, stride, n);
+		first += n;
+		num -= n;
 	}
+	if (num > 0) {
+		src = data->src_wrap;
+		len += decimation_run(data->decimation, datatype, dst + len, src + (first - before_wrap) * stride, stride,
+		                      num);
+	}
+	return len;
 }
 
 /**
  * serialize payload of data packets.
- * explicit signals contain arrays of datatype
+ * explicit signals contain arrays of datatype, or the encoded samples if an encoding is used
  * implicit signals contain one uint64 and one sample of datatype
  */
 static inline void tl_serialize_data_payload(unsigned char *dst, pl_data_t *data, size_t bytecount)
 {
 	signal_definition_t *def = data->signal_defintion;
-	if (def->rule == signal_explicit_rule) {
-		memcpy_le(dst, data->src, def->datatype, bytecount);
+	if (def->rule == signal_explicit_rule && data->encoding.mode != encoding_none) {
+		dst += encoding_write_header(&data->encoding, dst);
+		dst += encode_explicit_samples(dst, data, 0, data->encoding.num);
+		encoding_finish(&data->encoding, dst);
+	} else if (def->rule == signal_explicit_rule && data->decimation != NULL) {
+		decimate_explicit_samples(dst, data, 0, data->num_samples);
+	} else if (def->rule == signal_explicit_rule) {
+		size_t wire_size = wire_sample_size(def);
+		// unknown datatypes and invalid structs have no samples on the wire
+		if (wire_size != 0) {
+			copy_explicit_samples(dst, data, 0, bytecount / wire_size);
+		}
 	} else {
 		const uint64_t *ptr = (const uint64_t *)data->src;
 		SEGGER_WrU64LE(dst, *ptr++);
-		openDAQ_copy_sample_le(def->datatype, dst + sizeof(uint64_t), ptr);
+		streaming_copy_samples_le(def->datatype, dst + sizeof(uint64_t), ptr, 1);
 	}
 }
 
@@ -222,6 +334,24 @@ static inline void tl_serialize_meta_payload(unsigned char *dst, pl_meta_t *meta
 	memcpy(dst + 4, meta->meta_data, bytecount - 4);
 }
 
+/**
+ * serializes the payload of the transport layer packet, without any header
+ */
+static int tl_serialize_payload(tl_packet_t *packet, unsigned char *dst)
+{
+	switch (packet->packet_type) {
+	case TYPE_DATA:
+		tl_serialize_data_payload(dst, &packet->payload.data, packet->payload_size);
+		break;
+	case TYPE_META:
+		tl_serialize_meta_payload(dst, &packet->payload.meta, packet->payload_size);
+		break;
+	default:
+		return -2;
+	}
+	return 0;
+}
+
 /***
  * serializes the transport layer packet with header
  */
@@ -240,19 +370,198 @@ static int tl_serialize_packet(tl_packet_t *packet, unsigned char *dst, size_t b
 		return -1;
 	}
 
-	dst += header_len;
+	int ret = tl_serialize_payload(packet, dst + header_len);
+	return ret < 0 ? ret : (int)(header_len + payload_len);
+}
+
+// a chunk holds whole 64 bit words and at least the encoding header plus the pending bits of encoding_finish
+_Static_assert(STREAMING_TX_CHUNK_SIZE % sizeof(uint64_t) == 0, "STREAMING_TX_CHUNK_SIZE must be a multiple of 8");
+_Static_assert(STREAMING_TX_CHUNK_SIZE >= ENCODING_HEADER_SIZE_MAX + sizeof(uint64_t),
+               "STREAMING_TX_CHUNK_SIZE must hold the encoding header and 8 bytes");
+
+/**
+ * sends the encoded payload of an explicit data packet together with its header.
+ * The samples are encoded in chunks through a small buffer on the stack, the header goes out with the first chunk.
+ */
+static int send_encoded_payload(const struct stream *stream, const unsigned char *header, size_t header_len,
+                                pl_data_t *data)
+{
+	encoding_t *enc = &data->encoding;
+	size_t max_sample_size = encoding_max_sample_size(enc->mode, enc->datatype);
+	unsigned char chunk[STREAMING_HEADER_SIZE_MAX + STREAMING_TX_CHUNK_SIZE];
+	size_t total = 0;
+
+	memcpy(chunk, header, header_len);
+	size_t used = header_len + encoding_write_header(enc, chunk + header_len);
+	for (size_t done = 0; done <= enc->num;) {
+		size_t n = (sizeof(chunk) - used) / max_sample_size;
+		if (n > enc->num - done) {
+			n = enc->num - done;
+		}
+		used += encode_explicit_samples(chunk + used, data, done, n);
+		done += n;
+		if (done == enc->num && sizeof(chunk) - used >= sizeof(uint64_t)) {
+			// room for the pending bits, this is the last chunk
+			used += encoding_finish(enc, chunk + used);
+			done++;
+		}
+
+		if (used == 0) {
+			continue;
+		}
+		int ret = stream->stream(stream, (const char *)chunk, used);
+		if (ret < 0) {
+			return ret;
+		}
+		total += ret;
+		used = 0;
+	}
+	return total;
+}
+
+/**
+ * sends the decimated payload of an explicit data packet together with its header. Each chunk takes the input
+ * samples of as many buckets as fit into the chunk, the header goes out with the first chunk.
+ */
+static int send_decimated_payload(const struct stream *stream, const unsigned char *header, size_t header_len,
+                                  pl_data_t *data)
+{
+	size_t sample_size = openDAQ_get_sample_size(data->signal_defintion->datatype);
+	unsigned char chunk[STREAMING_HEADER_SIZE_MAX + STREAMING_TX_CHUNK_SIZE];
+	size_t used = header_len;
+	size_t total = 0;
+
+	memcpy(chunk, header, header_len);
+	for (size_t done = 0; done < data->num_samples;) {
+		size_t n = decimation_input_limit(data->decimation, STREAMING_TX_CHUNK_SIZE / sample_size);
+		if (n > data->num_samples - done) {
+			n = data->num_samples - done;
+		}
+		used += decimate_explicit_samples(chunk + used, data, done, n);
+		done += n;
+
+		if (used == 0) {
+			// the last samples only continue a bucket
+			continue;
+		}
+		int ret = stream->stream(stream, (const char *)chunk, used);
+		if (ret < 0) {
+			return ret;
+		}
+		total += ret;
+		used = 0;
+	}
+	return total;
+}
+
+/**
+ * sends an explicit data packet from its header and payload.
+ * Little endian targets hand contiguous samples to the socket as they are. Big endian targets, strided
+ * and quantized samples are converted in chunks through a small buffer on the stack, so the stack usage
+ * stays bounded. The header goes out with the first chunk.
+ */
+static int send_explicit_payload(const struct stream *stream, const unsigned char *header, size_t header_len,
+                                 pl_data_t *data, size_t payload_len)
+{
+	signal_definition_t *def = data->signal_defintion;
+	size_t sample_size = wire_sample_size(def);
+	bool contiguous = (data->stride == 0 || data->stride == sample_size) && !quantization_active(def) &&
+	                  def->datatype != signal_type_struct;
+
+	if (data->encoding.mode != encoding_none) {
+		return send_encoded_payload(stream, header, header_len, data);
+	}
+	if (data->decimation != NULL) {
+		return send_decimated_payload(stream, header, header_len, data);
+	}
+
+	if (sample_size == 0 || sample_size > STREAMING_TX_CHUNK_SIZE) {
+		// invalid signal, or a record which does not fit into a chunk
+		return -1;
+	}
+
+	if ((!STREAMING_BIG_ENDIAN || sample_size == 1) && contiguous) {
+		size_t first_len = data->src_wrap ? data->num_before_wrap * sample_size : payload_len;
+		stream_segment_t segments[3] = {
+		    {(const char *)header, header_len},
+		    {data->src, first_len},
+		    {data->src_wrap, payload_len - first_len},
+		};
+		return stream->streamv(stream, segments, data->src_wrap ? 3 : 2);
+	}
+
+	unsigned char chunk[STREAMING_HEADER_SIZE_MAX + STREAMING_TX_CHUNK_SIZE];
+	size_t chunk_samples = STREAMING_TX_CHUNK_SIZE / sample_size;
+	size_t num = payload_len / sample_size;
+	size_t used = header_len;
+	size_t total = 0;
+
+	memcpy(chunk, header, header_len);
+	for (size_t done = 0; done < num || used > 0;) {
+		size_t n = num - done < chunk_samples ? num - done : chunk_samples;
+		copy_explicit_samples(chunk + used, data, done, n);
+		used += n * sample_size;
+		int ret = stream->stream(stream, (const char *)chunk, used);
+		if (ret < 0) {
+			return ret;
+		}
+		done += n;
+		total += ret;
+		used = 0;
+	}
+	return total;
+}
+
+static int send_packet(const struct stream *stream, tl_packet_t *packet)
+{
+	// large enough for the headers plus the meta type or a complete implicit payload
+	unsigned char scratch[STREAMING_HEADER_SIZE_MAX + sizeof(uint64_t) + 16];
+	int header_len = serialize_header(packet, scratch, sizeof(scratch));
+
+	if (header_len < 0) {
+		return header_len;
+	}
+
 	switch (packet->packet_type) {
+	case TYPE_META: {
+		pl_meta_t *meta = &packet->payload.meta;
+		SEGGER_WrU32LE(scratch + header_len, meta->meta_type);
+		stream_segment_t segments[2] = {
+		    {(const char *)scratch, header_len + sizeof(uint32_t)},
+		    {meta->meta_data, packet->payload_size - sizeof(uint32_t)},
+		};
+		return stream->streamv(stream, segments, 2);
+	}
 	case TYPE_DATA:
-		tl_serialize_data_payload(dst, &packet->payload.data, payload_len);
-		break;
-	case TYPE_META:
-		tl_serialize_meta_payload(dst, &packet->payload.meta, payload_len);
-		break;
+		if (packet->payload.data.signal_defintion->rule == signal_explicit_rule) {
+			return send_explicit_payload(stream, scratch, header_len, &packet->payload.data, packet->payload_size);
+		}
+		if (header_len + packet->payload_size > sizeof(scratch)) {
+			return -1;
+		}
+		// implicit payloads are tiny, send them in one go
+		tl_serialize_data_payload(scratch + header_len, &packet->payload.data, packet->payload_size);
+		return stream->stream(stream, (const char *)scratch, header_len + packet->payload_size);
 	default:
 		return -2;
 	}
+}
 
-	return header_len + payload_len;
+int openDAQ_streaming_send_packet(const struct stream *stream, tl_packet_t *packet)
+{
+	// the bytes count as queued while the send blocks
+	size_t size = packet_header_size(packet->payload_size) + packet->payload_size;
+	streaming_congestion_begin(stream, size);
+	if (stream->lock != NULL) {
+		streaming_mutex_lock(&stream->lock->mutex);
+	}
+	int ret = send_packet(stream, packet);
+	if (stream->lock != NULL) {
+		streaming_mutex_unlock(&stream->lock->mutex);
+	}
+	// after the unlock, the fill level may be sent through the same stream
+	streaming_congestion_end(stream, size);
+	return ret;
 }
 
 void build_packet_meta_signal(tl_packet_t *packet, char *mpack_data, uint32_t mpack_size, uint32_t signal_num)
@@ -286,39 +595,694 @@ static void build_packet_data(tl_packet_t *packet, const char *data, signal_t *s
 	packet->signal_number = signal_get_signal_no(signal);
 	packet->payload.data.signal_defintion = signal->definition;
 	packet->payload.data.src = data;
+	packet->payload.data.stride = 0;
+	packet->payload.data.src_wrap = NULL;
+	packet->payload.data.num_before_wrap = 0;
+	packet->payload.data.encoding.mode = encoding_none;
+	packet->payload.data.decimation = NULL;
+	packet->payload.data.num_samples = 0;
 	packet->payload_size = data_size;
 }
 
+/**
+ * fill the packet structure for an explicit data packet. Samples of signals with an encoding are measured
+ * right away, so the payload size is known before the header is serialized. Samples of decimated signals are
+ * reduced while the payload is serialized, so every serialize and send function advances the decimation. The
+ * caller counts the samples as transmitted once the packet was serialized, sent or added to a frame.
+ *
+ * @return false if the samples of a decimated signal completed no bucket. They were taken into the decimation
+ *         and there is nothing to send.
+ */
+static bool build_packet_explicit(tl_packet_t *packet, signal_t *signal, const void *src, unsigned int num,
+                                  const void *src_wrap, unsigned int num_wrap, size_t stride)
+{
+	signal_data_type_e datatype = signal->definition->datatype;
+	size_t sample_size = source_sample_size(signal->definition);
+	size_t wire_size = wire_sample_size(signal->definition);
+	pl_data_t *data = &packet->payload.data;
+
+	build_packet_data(packet, src, signal, wire_size * (num + num_wrap));
+	data->stride = stride;
+	if (src_wrap != NULL && num_wrap > 0) {
+		data->src_wrap = src_wrap;
+		data->num_before_wrap = num;
+	}
+
+	if (signal->encoding != encoding_none) {
+		size_t src_stride = stride ? stride : sample_size;
+		encoding_begin(&data->encoding, signal->encoding, datatype);
+		encoding_measure(&data->encoding, src, src_stride, num);
+		if (data->src_wrap != NULL) {
+			encoding_measure(&data->encoding, src_wrap, src_stride, num_wrap);
+		}
+		packet->payload_size = encoding_size(&data->encoding);
+	} else if (decimation_active(&signal->decimation)) {
+		data->decimation = &signal->decimation;
+		data->num_samples = num + num_wrap;
+		packet->payload_size = wire_size * decimation_output_count(data->decimation, data->num_samples);
+		if (packet->payload_size == 0) {
+			// no bucket completes, dst is never written
+			decimate_explicit_samples(NULL, data, 0, data->num_samples);
+			signal->sample_index += data->num_samples;
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * fill the packet structure for an implicit data packet. The payload is index and sample, which are
+ * gathered in buf, so buf must stay valid until the packet is serialized.
+ */
+static void build_packet_implicit(tl_packet_t *packet, uint64_t buf[3], uint64_t index, signal_t *signal,
+                                  const void *src)
+{
+	size_t sample_size = openDAQ_get_sample_size(signal->definition->datatype);
+
+	index = signal_wire_index(signal, index);
+	memcpy(&buf[0], &index, sizeof(index));
+	memcpy(&buf[1], src, sample_size);
+
+	build_packet_data(packet, (const char *)buf, signal, sample_size + sizeof(uint64_t));
+}
+
+/**
+ * constant rule signals only need to be sent when their value changes, or when a keyframe is due
+ */
+static bool constant_sample_due(signal_t *signal, uint64_t index, const void *src)
+{
+	signal_definition_t *def = signal->definition;
+
+	if (def->rule != signal_constant_rule || !signal->last_valid) {
+		return true;
+	}
+	if (def->keyframe != 0 && index - signal->last_index >= def->keyframe) {
+		return true;
+	}
+	return memcmp(signal->last_value, src, openDAQ_get_sample_size(def->datatype)) != 0;
+}
+
+static void signal_sample_sent(signal_t *signal, uint64_t index, const void *src)
+{
+	memcpy(signal->last_value, src, openDAQ_get_sample_size(signal->definition->datatype));
+	signal->last_index = index;
+	signal->last_valid = true;
+}
+
 int openDAQ_streaming_serialize_constant_signal(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
                                                 const void *src)
 {
-	return openDAQ_streaming_serialize_implicit_signal(dst, dst_size, index, signal, src);
+	if (!constant_sample_due(signal, index, src)) {
+		return 0;
+	}
+
+	int ret = openDAQ_streaming_serialize_implicit_signal(dst, dst_size, index, signal, src);
+	if (ret > 0) {
+		signal_sample_sent(signal, index, src);
+	}
+	return ret;
 }
 int openDAQ_streaming_serialize_linear_signal(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
                                               const void *src)
 {
-	return openDAQ_streaming_serialize_implicit_signal(dst, dst_size, index, signal, src);
+	int ret = openDAQ_streaming_serialize_implicit_signal(dst, dst_size, index, signal, src);
+	if (ret > 0) {
+		signal_sample_sent(signal, index, src);
+	}
+	return ret;
+}
+
+/**
+ * a linear signal needs a new start value if the observed value deviates from the value the client
+ * calculates from the last start value by more than the tolerance
+ */
+static int linear_sample_due(signal_t *signal, uint64_t index, const void *src)
+{
+	signal_definition_t *def = signal->definition;
+	int64_t observed;
+	int64_t start;
+
+	if (!streaming_sample_to_int64(def->datatype, src, &observed)) {
+		// only integer types can be tracked
+		return -1;
+	}
+	if (!signal->last_valid) {
+		return 1;
+	}
+
+	streaming_sample_to_int64(def->datatype, signal->last_value, &start);
+	uint64_t predicted = (uint64_t)start + (index - signal->last_index) * def->delta;
+	int64_t deviation = (int64_t)((uint64_t)observed - predicted);
+	uint64_t abs_deviation = deviation < 0 ? -(uint64_t)deviation : (uint64_t)deviation;
+	return abs_deviation > def->tolerance;
+}
+
+int openDAQ_streaming_serialize_linear_tracked(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
+                                               const void *src)
+{
+	int due = linear_sample_due(signal, index, src);
+	if (due <= 0) {
+		return due;
+	}
+	return openDAQ_streaming_serialize_linear_signal(dst, dst_size, index, signal, src);
+}
+
+/**
+ * start value of a linear signal at index, continued from its last start value. Only integer domains of which a
+ * start value was sent can be continued.
+ */
+static bool gap_start_value(signal_t *linear, uint64_t index, uint64_t sample[2])
+{
+	signal_definition_t *def = linear->definition;
+	int64_t start;
+
+	if (def->rule != signal_linear_rule || !signal_has_subscription(linear) || !linear->last_valid ||
+	    !streaming_sample_to_int64(def->datatype, linear->last_value, &start)) {
+		return false;
+	}
+
+	uint64_t value = (uint64_t)start + (index - linear->last_index) * def->delta;
+	uint8_t u8 = value;
+	uint16_t u16 = value;
+	uint32_t u32 = value;
+	switch (openDAQ_get_sample_size(def->datatype)) {
+	case 1:
+		memcpy(sample, &u8, sizeof(u8));
+		break;
+	case 2:
+		memcpy(sample, &u16, sizeof(u16));
+		break;
+	case 4:
+		memcpy(sample, &u32, sizeof(u32));
+		break;
+	default:
+		memcpy(sample, &value, sizeof(value));
+		break;
+	}
+	return true;
+}
+
+/**
+ * skips num dropped samples of an explicit signal. The next sample keeps its index, the client does not count
+ * the dropped samples, so the indices of the table are shifted by them from now on.
+ *
+ * @return false if the signal has no table, there is no domain to correct
+ */
+static bool gap_skip(signal_t *signal, uint32_t num)
+{
+	signal->sample_index += num;
+	if (signal->table == NULL) {
+		return false;
+	}
+	signal->table->dropped += num;
+	return true;
+}
+
+size_t openDAQ_streaming_gap_size(signal_t *signal)
+{
+	signal_table_t *table = signal->table;
+	uint64_t sample[2];
+	size_t size = 0;
+
+	for (unsigned int i = 0; table != NULL && i < table->signal_counter; i++) {
+		if (gap_start_value(&table->signals[i], signal->sample_index, sample)) {
+			size += openDAQ_streaming_linear_size(&table->signals[i]);
+		}
+	}
+	return size;
+}
+
+int openDAQ_streaming_serialize_gap(void *dst, size_t dst_size, signal_t *signal, uint32_t num)
+{
+	unsigned char *dst_ptr = dst;
+	uint64_t sample[2];
+
+	if (num == 0) {
+		return 0;
+	}
+	if (openDAQ_streaming_gap_size(signal) > dst_size) {
+		return -1;
+	}
+	if (!gap_skip(signal, num)) {
+		return 0;
+	}
+
+	for (unsigned int i = 0; i < signal->table->signal_counter; i++) {
+		signal_t *linear = &signal->table->signals[i];
+		if (!gap_start_value(linear, signal->sample_index, sample)) {
+			continue;
+		}
+		int ret = openDAQ_streaming_serialize_linear_signal(dst_ptr, dst_size - (dst_ptr - (unsigned char *)dst),
+		                                                    signal->sample_index, linear, sample);
+		if (ret < 0) {
+			return ret;
+		}
+		dst_ptr += ret;
+	}
+	return dst_ptr - (unsigned char *)dst;
+}
+
+int openDAQ_streaming_send_gap(const struct stream *stream, signal_t *signal, uint32_t num)
+{
+	uint64_t sample[2];
+	int sent = 0;
+
+	if (num == 0 || !gap_skip(signal, num)) {
+		return 0;
+	}
+
+	for (unsigned int i = 0; i < signal->table->signal_counter; i++) {
+		signal_t *linear = &signal->table->signals[i];
+		if (!gap_start_value(linear, signal->sample_index, sample)) {
+			continue;
+		}
+		int ret = openDAQ_streaming_send_implicit_signal(stream, signal->sample_index, linear, sample);
+		if (ret < 0) {
+			return ret;
+		}
+		signal_sample_sent(linear, signal->sample_index, sample);
+		sent += ret;
+	}
+	return sent;
+}
+
+uint64_t openDAQ_streaming_pack_bits(const bool *flags, unsigned int count)
+{
+	uint64_t word = 0;
+
+	for (unsigned int i = 0; i < count && i < 64; i++) {
+		word |= (uint64_t)(flags[i] != 0) << i;
+	}
+	return word;
+}
+
+int openDAQ_streaming_serialize_bitfield_signal(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
+                                                const bool *flags)
+{
+	signal_definition_t *def = signal->definition;
+	union {
+		uint8_t u8;
+		uint16_t u16;
+		uint32_t u32;
+		uint64_t u64;
+	} sample;
+
+	if (def->rule == signal_explicit_rule || !signal_data_type_is_bitfield(def->datatype)) {
+		return -2;
+	}
+
+	unsigned int width = openDAQ_get_sample_size(def->datatype) * 8;
+	unsigned int count = def->bitfield != NULL && def->bitfield->num_bits < width ? def->bitfield->num_bits : width;
+	uint64_t word = openDAQ_streaming_pack_bits(flags, count);
+
+	// narrow the word in host byte order, the sample is swapped on serialization
+	switch (def->datatype) {
+	case signal_type_bitfield8:
+		sample.u8 = word;
+		break;
+	case signal_type_bitfield16:
+		sample.u16 = word;
+		break;
+	case signal_type_bitfield32:
+		sample.u32 = word;
+		break;
+	default:
+		sample.u64 = word;
+		break;
+	}
+	return openDAQ_streaming_serialize_constant_signal(dst, dst_size, index, signal, &sample);
 }
 
 int openDAQ_streaming_serialize_implicit_signal(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
                                                 const void *src)
 {
 	tl_packet_t packet = {0};
-	size_t sample_size = openDAQ_get_sample_size(signal->definition->datatype);
-
 	uint64_t buf[3]; // large enough buffer to hold everything
-	memcpy(&buf[0], &index, sizeof(index));
-	memcpy(&buf[1], src, sample_size);
-
-	build_packet_data(&packet, (const char *)buf, signal, sample_size + sizeof(uint64_t));
+	build_packet_implicit(&packet, buf, index, signal, src);
 	return tl_serialize_packet(&packet, dst, dst_size);
 }
 
 int openDAQ_streaming_serialize_explicit_signal(void *dst, size_t dst_size, signal_t *signal, const void *src,
                                                 unsigned int num)
+{
+	return openDAQ_streaming_serialize_explicit_signal_ring(dst, dst_size, signal, src, num, NULL, 0, 0);
+}
+/**
+ * signals of a table written by openDAQ_streaming_serialize_implicit_table
+ */
+static inline bool table_signal_selected(signal_t *signal, uint64_t index, const void *src)
+{
+	return src != NULL && signal->definition->rule != signal_explicit_rule && signal_has_subscription(signal) &&
+	       constant_sample_due(signal, index, src);
+}
+
+int openDAQ_streaming_serialize_implicit_table(void *dst, size_t dst_size, uint64_t index, signal_table_t *table,
+                                               const void *const *src)
+{
+	unsigned char *dst_ptr = dst;
+	size_t size = 0;
+
+	for (unsigned int i = 0; i < table->signal_counter; i++) {
+		if (table_signal_selected(&table->signals[i], index, src[i])) {
+			size += openDAQ_streaming_implicit_size(&table->signals[i]);
+		}
+	}
+
+	// one bounds check for the whole table, the packets below are written unchecked
+	if (size > dst_size) {
+		return -1;
+	}
+
+	for (unsigned int i = 0; i < table->signal_counter; i++) {
+		signal_t *signal = &table->signals[i];
+		if (!table_signal_selected(signal, index, src[i])) {
+			continue;
+		}
+		signal_sample_sent(signal, index, src[i]);
+
+		signal_data_type_e datatype = signal->definition->datatype;
+		tl_packet_t packet = {
+		    .packet_type = TYPE_DATA,
+		    .signal_number = signal_get_signal_no(signal),
+		    .payload_size = openDAQ_get_sample_size(datatype) + sizeof(uint64_t),
+		};
+		dst_ptr += write_header(&packet, dst_ptr);
+		SEGGER_WrU64LE(dst_ptr, signal_wire_index(signal, index));
+		streaming_copy_samples_le(datatype, dst_ptr + sizeof(uint64_t), src[i], 1);
+		dst_ptr += packet.payload_size;
+	}
+
+	return size;
+}
+
+int openDAQ_streaming_serialize_explicit_signal_strided(void *dst, size_t dst_size, signal_t *signal,
+                                                        const void *src, size_t stride, unsigned int num)
+{
+	return openDAQ_streaming_serialize_explicit_signal_ring(dst, dst_size, signal, src, num, NULL, 0, stride);
+}
+
+int openDAQ_streaming_serialize_explicit_signal_ring(void *dst, size_t dst_size, signal_t *signal, const void *src,
+                                                     unsigned int num, const void *src_wrap, unsigned int num_wrap,
+                                                     size_t stride)
 {
 	tl_packet_t packet = {0};
-	size_t sample_size = openDAQ_get_sample_size(signal->definition->datatype);
-	build_packet_data(&packet, src, signal, sample_size * num);
-	return tl_serialize_packet(&packet, dst, dst_size);
-}
\ No newline at end of file
+	if (!build_packet_explicit(&packet, signal, src, num, src_wrap, num_wrap, stride)) {
+		return 0;
+	}
+	int ret = tl_serialize_packet(&packet, dst, dst_size);
+	if (ret >= 0) {
+		signal->sample_index += num + num_wrap;
+	}
+	return ret;
+}
+
+int openDAQ_streaming_send_implicit_signal(const struct stream *stream, uint64_t index, signal_t *signal,
+                                           const void *src)
+{
+	tl_packet_t packet = {0};
+	uint64_t buf[3]; // large enough buffer to hold everything
+	build_packet_implicit(&packet, buf, index, signal, src);
+	return openDAQ_streaming_send_packet(stream, &packet);
+}
+
+int openDAQ_streaming_send_explicit_signal(const struct stream *stream, signal_t *signal, const void *src,
+                                           unsigned int num)
+{
+	tl_packet_t packet = {0};
+
+	if (streaming_congestion_admit(signal) == congestion_drop) {
+		// nothing older is waiting, so the block itself goes. Signalling the gap waits for the congestion to clear.
+		streaming_congestion_dropped(stream, num);
+		signal->gap += num;
+		return 0;
+	}
+	int sent = openDAQ_streaming_send_gap(stream, signal, signal->gap);
+	if (sent < 0) {
+		return sent;
+	}
+	signal->gap = 0;
+	if (!build_packet_explicit(&packet, signal, src, num, NULL, 0, 0)) {
+		return sent;
+	}
+	int ret = openDAQ_streaming_send_packet(stream, &packet);
+	if (ret < 0) {
+		return ret;
+	}
+	signal->sample_index += num;
+	return sent + ret;
+}
+
+/**
+ * upper bound of the payload size of num explicit samples, the exact size if the samples are not encoded
+ */
+static size_t explicit_payload_max_size(signal_t *signal, unsigned int num)
+{
+	if (decimation_active(&signal->decimation)) {
+		return wire_sample_size(signal->definition) * decimation_output_count(&signal->decimation, num);
+	}
+	if (signal->encoding == encoding_none) {
+		return wire_sample_size(signal->definition) * num;
+	}
+	return encoding_max_size(signal->encoding, signal_wire_datatype(signal->definition), num);
+}
+
+static size_t explicit_sample_max_size(signal_t *signal)
+{
+	if (signal->encoding == encoding_none) {
+		return wire_sample_size(signal->definition);
+	}
+	return encoding_max_sample_size(signal->encoding, signal_wire_datatype(signal->definition));
+}
+
+size_t openDAQ_streaming_explicit_size(signal_t *signal, unsigned int num)
+{
+	size_t payload_size = explicit_payload_max_size(signal, num);
+	return packet_header_size(payload_size) + payload_size;
+}
+
+int openDAQ_streaming_parse_header(const void *src, size_t len, streaming_packet_info_t *info)
+{
+	const unsigned char *ptr = src;
+	size_t websocket_header = 0;
+	uint64_t frame_size = 0;
+
+#ifdef WEBSOCKET_STREAMING
+	if (len < 2) {
+		return 0;
+	}
+	frame_size = ptr[1] & 0x7f;
+	if (frame_size < 126) {
+		websocket_header = 2;
+	} else {
+		websocket_header = frame_size == 126 ? 4 : 10;
+		if (len < websocket_header) {
+			return 0;
+		}
+		frame_size = 0;
+		for (size_t i = 2; i < websocket_header; i++) {
+			frame_size = (frame_size << 8) | ptr[i];
+		}
+	}
+#endif
+	if (len < websocket_header + 4) {
+		return 0;
+	}
+
+	uint32_t word = SEGGER_RdU32LE(ptr + websocket_header);
+	info->packet_type = (type_t)((word & TYPE_MASK) >> TYPE_SHIFT);
+	info->signal_number = (word & SIGNAL_NUMBER_MASK) >> SIGNAL_NUMBER_SHIFT;
+#ifdef WEBSOCKET_STREAMING
+	info->length = websocket_header + frame_size;
+#else
+	uint32_t payload_size = (word & SIZE_MASK) >> SIZE_SHIFT;
+	if (payload_size != 0) {
+		info->length = 4 + payload_size;
+	} else {
+		// long header, the payload size follows
+		if (len < 8) {
+			return 0;
+		}
+		info->length = 8 + SEGGER_RdU32LE(ptr + 4);
+	}
+	(void)frame_size;
+#endif
+	return 1;
+}
+
+size_t openDAQ_streaming_source_sample_size(signal_t *signal)
+{
+	return source_sample_size(signal->definition);
+}
+
+size_t openDAQ_streaming_implicit_size(signal_t *signal)
+{
+	size_t payload_size = openDAQ_get_sample_size(signal->definition->datatype) + sizeof(uint64_t);
+	return packet_header_size(payload_size) + payload_size;
+}
+
+size_t openDAQ_streaming_constant_size(signal_t *signal)
+{
+	return openDAQ_streaming_implicit_size(signal);
+}
+
+size_t openDAQ_streaming_linear_size(signal_t *signal)
+{
+	return openDAQ_streaming_implicit_size(signal);
+}
+
+size_t openDAQ_streaming_writes_size(const signal_write_t *writes, unsigned int count)
+{
+	size_t size = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		if (writes[i].signal->definition->rule == signal_explicit_rule) {
+			size += openDAQ_streaming_explicit_size(writes[i].signal, writes[i].num);
+		} else {
+			size += openDAQ_streaming_implicit_size(writes[i].signal);
+		}
+	}
+	return size;
+}
+
+unsigned int openDAQ_streaming_explicit_max_samples(signal_t *signal, size_t size)
+{
+	size_t sample_size = explicit_sample_max_size(signal);
+	if (sample_size == 0 || source_sample_size(signal->definition) == 0) {
+		// unknown datatype or invalid struct, e.g. a struct without fields
+		return 0;
+	}
+	size_t num = size > STREAMING_HEADER_SIZE_MAX ? (size - STREAMING_HEADER_SIZE_MAX) / sample_size : 0;
+	if (decimation_active(&signal->decimation)) {
+		// the estimate counts output samples, each takes several input samples
+		num = decimation_input_limit(&signal->decimation, num);
+		if (num == 0) {
+			// not even one bucket fits
+			return 0;
+		}
+	}
+
+	// the estimate ignores the header of encoded payloads, which might not leave room for all samples
+	while (num > 0 && openDAQ_streaming_explicit_size(signal, num) > size) {
+		num--;
+	}
+	// the estimate assumed the largest headers, smaller payloads might leave room for a few more samples
+	while (openDAQ_streaming_explicit_size(signal, num + 1) <= size) {
+		num++;
+	}
+	return num;
+}
+
+int openDAQ_streaming_serialize_explicit_signal_chunked(void *dst, size_t dst_size, size_t segment_size,
+                                                        signal_t *signal, const void *src, unsigned int num,
+                                                        unsigned int *consumed)
+{
+	size_t sample_size = source_sample_size(signal->definition);
+	unsigned int samples_per_segment = openDAQ_streaming_explicit_max_samples(signal, segment_size);
+	bool decimated = decimation_active(&signal->decimation);
+	unsigned char *dst_ptr = dst;
+	const unsigned char *src_ptr = src;
+	unsigned int done = 0;
+
+	*consumed = 0;
+	if (sample_size == 0 || samples_per_segment == 0) {
+		// invalid signal, or the segment cannot even hold a single sample
+		return -1;
+	}
+
+	while (done < num) {
+		if (decimated && done > 0) {
+			// the samples a segment takes depend on the incomplete bucket
+			samples_per_segment = openDAQ_streaming_explicit_max_samples(signal, segment_size);
+		}
+		unsigned int chunk = num - done < samples_per_segment ? num - done : samples_per_segment;
+		size_t space = dst_size - (dst_ptr - (unsigned char *)dst);
+
+		if (openDAQ_streaming_explicit_size(signal, chunk) > space) {
+			// use the remaining space for a smaller packet
+			chunk = openDAQ_streaming_explicit_max_samples(signal, space);
+			if (chunk == 0) {
+				break;
+			}
+		}
+
+		int ret = openDAQ_streaming_serialize_explicit_signal(dst_ptr, space, signal, src_ptr, chunk);
+		if (ret < 0) {
+			return ret;
+		}
+		dst_ptr += ret;
+		src_ptr += chunk * sample_size;
+		done += chunk;
+	}
+
+	*consumed = done;
+	return dst_ptr - (unsigned char *)dst;
+}
+
+void openDAQ_streaming_frame_begin(streaming_frame_t *frame, void *dst, size_t dst_size)
+{
+	frame->buf = dst;
+	frame->size = dst_size;
+	// keep room for the largest websocket header, the frame length is only known when finishing
+	frame->used = STREAMING_WEBSOCKET_HEADER_SIZE_MAX;
+}
+
+/**
+ * appends one transport layer packet without websocket header to the frame
+ */
+static int frame_add_packet(streaming_frame_t *frame, tl_packet_t *packet)
+{
+	size_t packet_size = tl_header_size(packet->payload_size) + packet->payload_size;
+
+	if (frame->used + packet_size > frame->size) {
+		return -1;
+	}
+
+	unsigned char *dst = frame->buf + frame->used;
+	int ret = tl_serialize_payload(packet, dst + serialize_tl_header(packet, dst));
+	if (ret < 0) {
+		return ret;
+	}
+	frame->used += packet_size;
+	return packet_size;
+}
+
+int openDAQ_streaming_frame_add_explicit(streaming_frame_t *frame, signal_t *signal, const void *src,
+                                         unsigned int num)
+{
+	tl_packet_t packet = {0};
+	if (!build_packet_explicit(&packet, signal, src, num, NULL, 0, 0)) {
+		return 0;
+	}
+	int ret = frame_add_packet(frame, &packet);
+	if (ret >= 0) {
+		signal->sample_index += num;
+	}
+	return ret;
+}
+
+int openDAQ_streaming_frame_add_implicit(streaming_frame_t *frame, uint64_t index, signal_t *signal, const void *src)
+{
+	tl_packet_t packet = {0};
+	uint64_t buf[3]; // large enough buffer to hold everything
+	build_packet_implicit(&packet, buf, index, signal, src);
+	return frame_add_packet(frame, &packet);
+}
+
+int openDAQ_streaming_frame_finish(streaming_frame_t *frame, void **start)
+{
+	size_t payload_size = frame->used - STREAMING_WEBSOCKET_HEADER_SIZE_MAX;
+	unsigned char *frame_start = frame->buf + STREAMING_WEBSOCKET_HEADER_SIZE_MAX;
+
+	if (payload_size == 0) {
+		// an empty frame is not sent at all
+		*start = frame_start;
+		return 0;
+	}
+
+#ifdef WEBSOCKET_STREAMING
+	// the header is placed right in front of the payload, unused reserved bytes stay in front of it
+	frame_start -= websocket_length_header_size(payload_size);
+	serialize_websocket_header(frame_start, payload_size);
+#endif
+	*start = frame_start;
+	return frame->buf + frame->used - frame_start;
+}
@@ -2,11 +2,20 @@
 #define _STREAMING_PACKET_H_
 
 #include "stream_id.h"
+#include "streaming_encoding.h"
 #include "streaming_signals.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
+// largest possible websocket header (10 bytes) plus transport layer header (8 bytes)
+#ifdef WEBSOCKET_STREAMING
+	#define STREAMING_WEBSOCKET_HEADER_SIZE_MAX (10)
+#else
+	#define STREAMING_WEBSOCKET_HEADER_SIZE_MAX (0)
+#endif
+#define STREAMING_HEADER_SIZE_MAX (STREAMING_WEBSOCKET_HEADER_SIZE_MAX + 8)
+
 // Packet can either deliver DATA or METAINFORMATION
 typedef enum { TYPE_DATA = 1, TYPE_META = 2 } type_t;
 
@@ -22,6 +31,17 @@ typedef struct {
 typedef struct {
 	const void *src;
 	signal_definition_t *signal_defintion;
+	// explicit signals only: distance in bytes between two samples at src, 0 for contiguous samples
+	size_t stride;
+	// explicit signals only: samples following the wrap of a ring buffer, NULL if src holds all samples
+	const void *src_wrap;
+	uint32_t num_before_wrap;
+	// explicit signals only: payload encoding, the payload size is the size of the encoded samples
+	encoding_t encoding;
+	// explicit signals only: decimation of the subscription, NULL if the samples are sent as they are
+	decimation_t *decimation;
+	// decimated explicit signals only: number of input samples at src and src_wrap
+	uint32_t num_samples;
 } pl_data_t;
 
 typedef union {
@@ -36,12 +56,35 @@ typedef struct {
 	tl_payload_t payload;
 } tl_packet_t;
 
+// one pending signal write, num is ignored for implicit signals
+typedef struct {
+	signal_t *signal;
+	unsigned int num;
+} signal_write_t;
+
+// headers of a serialized packet, see openDAQ_streaming_parse_header
+typedef struct {
+	// size in bytes of the packet including all headers
+	size_t length;
+	type_t packet_type;
+	uint32_t signal_number;
+} streaming_packet_info_t;
+
+// a websocket frame holding several transport layer packets, see openDAQ_streaming_frame_begin
+typedef struct {
+	unsigned char *buf;
+	size_t size;
+	size_t used;
+} streaming_frame_t;
+
 // packet building functions used internally
 void build_packet_meta_stream(tl_packet_t *packet, char *mpack_data, uint32_t mpack_size);
 void build_packet_meta_signal(tl_packet_t *packet, char *mpack_data, uint32_t mpack_size, uint32_t signal_no);
 
 /**
- * sends a packet through the stream. The packet is firsted serialized into a buffer on the stack
+ * sends a packet through the stream. Only the headers are serialized into a small buffer on the stack,
+ * the payload is handed to the stream as a second segment without being copied.
+ * The lock of the stream, if any, is held for the whole packet.
  * packets are generated with build_packet_meta_stream or build_packet_meta_signal
  *
  * @param stream the stream to send the packet through
@@ -54,6 +97,8 @@ int openDAQ_streaming_send_packet(const struct stream *stream, tl_packet_t *pack
 
 /**
  * serializes an explicit signal into a buffer.
+ * If the subscription of the signal requested decimation, only the completed buckets are written. This holds
+ * for all explicit serialization and send functions.
  *
  * @param dst pointer to destination buffer
  * @param dst_size size in bytes of destination buffer
@@ -62,13 +107,132 @@ int openDAQ_streaming_send_packet(const struct stream *stream, tl_packet_t *pack
  * @param number of signal samples to at src to serialize
  *
  * @return <0    error
+ *         0     decimation did not complete a bucket, nothing written
  *         else  number of bytes written
  */
 int openDAQ_streaming_serialize_explicit_signal(void *dst, size_t dst_size, signal_t *signal, const void *src,
                                                 unsigned int num);
 
+/**
+ * serializes one sample of all subscribed implicit (constant and linear) signals of a table at the same index.
+ * All packets are written in a single pass after a single bounds check.
+ *
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ * @param index the index of the samples to transmit
+ * @param table the table of the signals
+ * @param src array with one sample pointer per table signal, in the order of the table's signal definitions.
+ *            Signals with a NULL pointer, explicit signals and unsubscribed signals are skipped. Constant
+ *            signals are skipped if their value is unchanged, see openDAQ_streaming_serialize_constant_signal.
+ *
+ * @return <0    error: destination buffer too small, nothing written
+ *         else  number of bytes written
+ */
+int openDAQ_streaming_serialize_implicit_table(void *dst, size_t dst_size, uint64_t index, signal_table_t *table,
+                                               const void *const *src);
+
+/**
+ * serializes an explicit signal whose samples are interleaved with other data, e.g. the channels of
+ * an interleaved ADC buffer. The samples are de-interleaved and swapped to little endian in one pass.
+ *
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ * @param signal pointer to the signal to serialize
+ * @param src pointer to the first sample
+ * @param stride distance in bytes between two consecutive samples at src
+ * @param num number of signal samples at src to serialize
+ *
+ * @return <0    error
+ *         else  number of bytes written
+ */
+int openDAQ_streaming_serialize_explicit_signal_strided(void *dst, size_t dst_size, signal_t *signal,
+                                                        const void *src, size_t stride, unsigned int num);
+
+/**
+ * serializes an explicit signal directly from a circular (DMA) buffer. The samples before the wrap
+ * start at src, the samples after the wrap start at src_wrap, usually the beginning of the buffer.
+ * Both segments are written into a single packet.
+ *
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ * @param signal pointer to the signal to serialize
+ * @param src pointer to the first sample before the wrap
+ * @param num number of samples before the wrap
+ * @param src_wrap pointer to the first sample after the wrap, may be NULL if num_wrap is 0
+ * @param num_wrap number of samples after the wrap
+ * @param stride distance in bytes between two consecutive samples, 0 for contiguous samples
+ *
+ * @return <0    error
+ *         else  number of bytes written
+ */
+int openDAQ_streaming_serialize_explicit_signal_ring(void *dst, size_t dst_size, signal_t *signal, const void *src,
+                                                     unsigned int num, const void *src_wrap, unsigned int num_wrap,
+                                                     size_t stride);
+
+/**
+ * serializes an arbitrarily long array of explicit samples as a sequence of packets.
+ * Every packet including its headers is at most segment_size bytes (e.g. the TCP MSS) and packets are
+ * only split on sample boundaries. Serialization stops when all samples are consumed or dst is full.
+ *
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ * @param segment_size maximum size in bytes of a single packet
+ * @param signal pointer to the signal to serialize
+ * @param src pointer to the payload data
+ * @param num number of signal samples at src to serialize
+ * @param consumed returns the number of samples serialized
+ *
+ * @return <0    error, e.g. segment_size cannot hold a single sample
+ *         else  number of bytes written
+ */
+int openDAQ_streaming_serialize_explicit_signal_chunked(void *dst, size_t dst_size, size_t segment_size,
+                                                        signal_t *signal, const void *src, unsigned int num,
+                                                        unsigned int *consumed);
+
+/**
+ * signals that num samples of an explicit signal were dropped in front of its next sample. The client counts the
+ * samples it receives, so without notice it would stamp the following samples too early. The subscribed integer
+ * linear signals of the table get a new start value at the index of the next sample instead, and the indices of
+ * the table are shifted by the dropped samples from now on.
+ *
+ * The domain is shared by all value signals of the table, so the timestamps stay exact only for the signal that
+ * dropped samples. Tables with a single subscribed value signal are exact.
+ *
+ * @param dst pointer to destination buffer, must hold openDAQ_streaming_gap_size bytes
+ * @param dst_size size in bytes of destination buffer
+ * @param signal the explicit signal which dropped samples
+ * @param num number of samples dropped
+ *
+ * @return <0    error, dst too small
+ *         0     nothing to correct, the samples are skipped nevertheless
+ *         else  number of bytes written
+ */
+int openDAQ_streaming_serialize_gap(void *dst, size_t dst_size, signal_t *signal, uint32_t num);
+
+/**
+ * like openDAQ_streaming_serialize_gap, sends the new start values through stream
+ */
+int openDAQ_streaming_send_gap(const struct stream *stream, signal_t *signal, uint32_t num);
+
+/**
+ * bytes openDAQ_streaming_serialize_gap writes for signal
+ */
+size_t openDAQ_streaming_gap_size(signal_t *signal);
+
+/**
+ * number of samples of an explicit signal that fit into one packet of size bytes including all headers.
+ *
+ * @param signal pointer to the signal to serialize
+ * @param size size in bytes available for the packet
+ *
+ * @return number of samples
+ */
+unsigned int openDAQ_streaming_explicit_max_samples(signal_t *signal, size_t size);
+
 /**
  * serializes a constant signal into a buffer.
+ * Nothing is written if the value equals the last value serialized for this signal. After a new subscription
+ * and after signal->definition->keyframe indices the value is written regardless.
  *
  * @param dst pointer to destination buffer
  * @param dst_size size in bytes of destination buffer
@@ -77,6 +241,7 @@ int openDAQ_streaming_serialize_explicit_signal(void *dst, size_t dst_size, sign
  * @param src pointer to the payload data
  *
  * @return <0    error
+ *         0     value unchanged, nothing written
  *         else  number of bytes written
  */
 int openDAQ_streaming_serialize_constant_signal(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
@@ -97,6 +262,55 @@ int openDAQ_streaming_serialize_constant_signal(void *dst, size_t dst_size, uint
 int openDAQ_streaming_serialize_linear_signal(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
                                               const void *src);
 
+/**
+ * serializes a linear signal only if the client would otherwise calculate a wrong value. The client calculates
+ * start + (index - start_index) * delta from the last value sent. The value is only written if the observed
+ * value, e.g. a hardware timestamp of an acquired block, deviates from this by more than
+ * signal->definition->tolerance, or if nothing was sent since the signal was subscribed.
+ * Only integer data types of up to 64 bit are supported.
+ *
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ * @param the index of the observed sample
+ * @param signal pointer to the signal to serialize
+ * @param src pointer to the observed value
+ *
+ * @return <0    error
+ *         0     value within tolerance, nothing written
+ *         else  number of bytes written
+ */
+int openDAQ_streaming_serialize_linear_tracked(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
+                                               const void *src);
+
+/**
+ * packs flags into one word, flags[0] becomes the least significant bit
+ *
+ * @param flags array of flags
+ * @param count number of flags, at most 64
+ *
+ * @return packed word
+ */
+uint64_t openDAQ_streaming_pack_bits(const bool *flags, unsigned int count);
+
+/**
+ * packs the flags of an implicit bitfield signal into one sample and serializes it. All flags update in a
+ * single packet. Constant rule signals are only written when a flag changed, see
+ * openDAQ_streaming_serialize_constant_signal.
+ *
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ * @param the index of the sample
+ * @param signal pointer to the signal to serialize
+ * @param flags one flag per bit of the signal, signal->definition->bitfield->num_bits flags or the width of
+ *              the bitfield if no bitfield object is given
+ *
+ * @return <0    error, -2 if the signal is not an implicit bitfield signal
+ *         0     no flag changed, nothing written
+ *         else  number of bytes written
+ */
+int openDAQ_streaming_serialize_bitfield_signal(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
+                                                const bool *flags);
+
 /**
  * serializes an implicit signal into a buffer.
  *
@@ -112,4 +326,129 @@ int openDAQ_streaming_serialize_linear_signal(void *dst, size_t dst_size, uint64
 int openDAQ_streaming_serialize_implicit_signal(void *dst, size_t dst_size, uint64_t index, signal_t *signal,
                                                 const void *src);
 
+/**
+ * serializes an explicit signal and sends it through the stream without copying the samples.
+ * Only the headers are placed on the stack. While the stream is congested the congestion policy of the signal
+ * applies, samples discarded by congestion_discard are signalled as gap in front of the next samples sent.
+ *
+ * @param stream the stream to send the signal through
+ * @param signal pointer to the signal to send
+ * @param src pointer to the payload data
+ * @param num number of signal samples at src to send
+ *
+ * @return <0    error
+ *         else  number of bytes written
+ */
+int openDAQ_streaming_send_explicit_signal(const struct stream *stream, signal_t *signal, const void *src,
+                                           unsigned int num);
+
+/**
+ * serializes an implicit signal and sends it through the stream.
+ *
+ * @param stream the stream to send the signal through
+ * @param the index of the sample to transmit
+ * @param signal pointer to the signal to send
+ * @param src pointer to the payload data
+ *
+ * @return <0    error
+ *         else  number of bytes written
+ */
+int openDAQ_streaming_send_implicit_signal(const struct stream *stream, uint64_t index, signal_t *signal,
+                                           const void *src);
+
+/**
+ * number of bytes openDAQ_streaming_serialize_explicit_signal writes for num samples, including the
+ * websocket and transport layer headers. The size is exact for raw payloads. For signals with an encoded
+ * payload the size depends on the sample values, this is an upper bound then.
+ *
+ * @param signal pointer to the signal to serialize
+ * @param num number of samples
+ *
+ * @return number of bytes required
+ */
+size_t openDAQ_streaming_explicit_size(signal_t *signal, unsigned int num);
+
+/**
+ * reads the headers of a serialized packet, e.g. to split a byte stream into packets again. With websocket framing
+ * the packet is the complete websocket frame, which may hold several transport layer packets, the type and signal
+ * number are the ones of the first. Without websocket framing an empty payload cannot be told from a long header,
+ * so packets without payload cannot be split.
+ *
+ * @param src serialized bytes starting with a packet
+ * @param len number of bytes at src
+ * @param info returns the headers
+ *
+ * @return 0     the headers are incomplete
+ *         else  info is valid
+ */
+int openDAQ_streaming_parse_header(const void *src, size_t len, streaming_packet_info_t *info);
+
+/**
+ * size in bytes of one explicit sample at the source, e.g. to size buffers holding samples of the signal.
+ * This is the record size for struct signals and the size of the unquantized datatype for quantized signals.
+ */
+size_t openDAQ_streaming_source_sample_size(signal_t *signal);
+
+/**
+ * exact number of bytes openDAQ_streaming_serialize_implicit_signal writes, including all headers.
+ * Constant and linear signals are implicit signals and have the same size.
+ *
+ * @param signal pointer to the signal to serialize
+ *
+ * @return number of bytes required
+ */
+size_t openDAQ_streaming_implicit_size(signal_t *signal);
+size_t openDAQ_streaming_constant_size(signal_t *signal);
+size_t openDAQ_streaming_linear_size(signal_t *signal);
+
+/**
+ * number of bytes required to serialize all pending writes consecutively into one buffer. The size is exact
+ * unless an explicit signal has an encoded payload, it is an upper bound then.
+ *
+ * @param writes array of pending signal writes
+ * @param count number of elements in writes
+ *
+ * @return number of bytes required
+ */
+size_t openDAQ_streaming_writes_size(const signal_write_t *writes, unsigned int count);
+
+/**
+ * starts a websocket frame in dst. Transport layer packets of different signals are appended to the frame,
+ * and the frame length is written when the frame is finished. All packets share a single websocket header.
+ * Without WEBSOCKET_STREAMING the frame is a plain concatenation of transport layer packets.
+ *
+ * @param frame the frame to start
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ */
+void openDAQ_streaming_frame_begin(streaming_frame_t *frame, void *dst, size_t dst_size);
+
+/**
+ * appends an explicit signal to the frame.
+ *
+ * @return <0    error: e.g. frame full
+ *         else  number of bytes appended
+ */
+int openDAQ_streaming_frame_add_explicit(streaming_frame_t *frame, signal_t *signal, const void *src,
+                                         unsigned int num);
+
+/**
+ * appends an implicit (constant or linear) signal to the frame.
+ *
+ * @return <0    error: e.g. frame full
+ *         else  number of bytes appended
+ */
+int openDAQ_streaming_frame_add_implicit(streaming_frame_t *frame, uint64_t index, signal_t *signal, const void *src);
+
+/**
+ * finishes the frame by writing its websocket header. The header is written right in front of the
+ * first packet, so the frame does not necessarily start at the beginning of dst.
+ *
+ * @param frame the frame to finish
+ * @param start returns the pointer to the first byte of the frame
+ *
+ * @return number of bytes to send starting at start, 0 if no packets were added
+ */
+int openDAQ_streaming_frame_finish(streaming_frame_t *frame, void **start);
+
 #endif
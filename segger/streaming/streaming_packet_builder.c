@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "streaming_packet_builder.h"
+#include "streaming_congestion.h"
+#include "streaming_packet.h"
+
+int streaming_packet_builder_alloc(streaming_packet_builder_t *builder, const struct stream *stream, size_t size)
+{
+	builder->stream = stream;
+	builder->used = 0;
+	builder->packet = stream->palloc(stream, size, &builder->data);
+	if (builder->packet == NULL) {
+		// without a packet there is no room, adding to the builder fails
+		builder->size = 0;
+		builder->data = NULL;
+		return -1;
+	}
+	builder->size = size;
+	return 0;
+}
+
+/**
+ * account for the bytes a serialize function wrote at the current position
+ */
+static int builder_advance(streaming_packet_builder_t *builder, int ret)
+{
+	if (ret > 0) {
+		builder->used += ret;
+	}
+	return ret;
+}
+
+int streaming_packet_builder_add_explicit(streaming_packet_builder_t *builder, signal_t *signal, const void *src,
+                                          unsigned int num)
+{
+	return builder_advance(builder,
+	                       openDAQ_streaming_serialize_explicit_signal(builder->data + builder->used,
+	                                                                   builder->size - builder->used, signal, src, num));
+}
+
+int streaming_packet_builder_add_constant(streaming_packet_builder_t *builder, uint64_t index, signal_t *signal,
+                                          const void *src)
+{
+	return builder_advance(builder,
+	                       openDAQ_streaming_serialize_constant_signal(builder->data + builder->used,
+	                                                                   builder->size - builder->used, index, signal, src));
+}
+
+int streaming_packet_builder_add_linear(streaming_packet_builder_t *builder, uint64_t index, signal_t *signal,
+                                        const void *src)
+{
+	return builder_advance(builder,
+	                       openDAQ_streaming_serialize_linear_signal(builder->data + builder->used,
+	                                                                 builder->size - builder->used, index, signal, src));
+}
+
+int streaming_packet_builder_add_implicit(streaming_packet_builder_t *builder, uint64_t index, signal_t *signal,
+                                          const void *src)
+{
+	return builder_advance(builder,
+	                       openDAQ_streaming_serialize_implicit_signal(builder->data + builder->used,
+	                                                                   builder->size - builder->used, index, signal, src));
+}
+
+int streaming_packet_builder_send(streaming_packet_builder_t *builder)
+{
+	const struct stream *stream = builder->stream;
+	void *packet = builder->packet;
+
+	builder->packet = NULL;
+	if (packet == NULL) {
+		return -1;
+	}
+	if (builder->used == 0) {
+		stream->pfree(stream, packet);
+		return 0;
+	}
+	if (builder->used < builder->size) {
+		stream->pshrink(stream, packet, builder->used);
+	}
+	// the packet is freed by streamp independent of the result
+	return streaming_congestion_packet_sent(stream, stream->streamp(stream, packet));
+}
+
+void streaming_packet_builder_discard(streaming_packet_builder_t *builder)
+{
+	if (builder->packet != NULL) {
+		builder->stream->pfree(builder->stream, builder->packet);
+		builder->packet = NULL;
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef _STREAMING_PACKET_BUILDER_H_
+#define _STREAMING_PACKET_BUILDER_H_
+
+#include "stream_id.h"
+#include "streaming_signals.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// collects serialized signals of any kind in one zero-copy packet of the stream
+typedef struct {
+	const struct stream *stream;
+	void *packet;
+	unsigned char *data;
+	size_t size;
+	size_t used;
+} streaming_packet_builder_t;
+
+/**
+ * allocates a zero-copy packet through the stream. The size can be calculated with
+ * openDAQ_streaming_writes_size, the packet is shrunk to the bytes actually written when it is sent.
+ *
+ * @param builder the builder to initialize
+ * @param stream the stream the packet is sent through
+ * @param size size in bytes of the packet
+ *
+ * @return <0    error: no packet available
+ *         0     OK
+ */
+int streaming_packet_builder_alloc(streaming_packet_builder_t *builder, const struct stream *stream, size_t size);
+
+/**
+ * serialize a signal into the packet, see the openDAQ_streaming_serialize_* functions.
+ *
+ * @return <0    error: e.g. not enough space left in the packet
+ *         else  number of bytes written
+ */
+int streaming_packet_builder_add_explicit(streaming_packet_builder_t *builder, signal_t *signal, const void *src,
+                                          unsigned int num);
+int streaming_packet_builder_add_constant(streaming_packet_builder_t *builder, uint64_t index, signal_t *signal,
+                                          const void *src);
+int streaming_packet_builder_add_linear(streaming_packet_builder_t *builder, uint64_t index, signal_t *signal,
+                                        const void *src);
+int streaming_packet_builder_add_implicit(streaming_packet_builder_t *builder, uint64_t index, signal_t *signal,
+                                          const void *src);
+
+/**
+ * shrinks the packet to the number of bytes serialized so far and sends it through stream->streamp.
+ * The packet is freed in any case, an empty packet is freed without sending it.
+ *
+ * @return see stream->streamp
+ */
+int streaming_packet_builder_send(streaming_packet_builder_t *builder);
+
+/**
+ * frees the packet without sending it
+ */
+void streaming_packet_builder_discard(streaming_packet_builder_t *builder);
+
+#endif
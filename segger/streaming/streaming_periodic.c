@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "streaming_periodic.h"
+#include "stream_passthrough.h"
+#include "streaming_congestion.h"
+#include <string.h>
+
+static uint64_t os_now_us(void *context)
+{
+	(void)context;
+	return streaming_os_time_us();
+}
+
+static void os_sleep_until_us(void *context, uint64_t time_us)
+{
+	(void)context;
+	streaming_os_sleep_until_us(time_us);
+}
+
+/**
+ * the bytes count towards the backlog of periodic->stream until they are sent, or are in flight in the send of
+ * their writer
+ */
+static int write_downstream(periodic_t *periodic, const char *buf, size_t len)
+{
+	int ret = stream_passthrough_write(&periodic->stream, buf, len);
+	periodic->stats.bytes += len;
+	return ret;
+}
+
+static int flush_locked(periodic_t *periodic)
+{
+	if (periodic->fill == 0) {
+		return 0;
+	}
+	int ret = write_downstream(periodic, (const char *)periodic->buffer, periodic->fill);
+	periodic->fill = 0;
+	return ret;
+}
+
+static int periodic_send(const struct stream *s, const char *buf, size_t len)
+{
+	periodic_t *periodic = (periodic_t *)s;
+	int ret = (int)len;
+
+	streaming_mutex_lock(&periodic->mutex);
+	if (periodic->error < 0) {
+		ret = periodic->error;
+		periodic->error = 0;
+		goto out;
+	}
+
+	if (periodic->fill + len > periodic->capacity) {
+		// more data than a cycle can hold, keep it rather than wait for the tick
+		periodic->stats.early_flushes++;
+		int err = flush_locked(periodic);
+		if (err < 0) {
+			ret = err;
+			goto out;
+		}
+	}
+	if (len > periodic->capacity) {
+		int err = write_downstream(periodic, buf, len);
+		if (err < 0) {
+			ret = err;
+		}
+		goto out;
+	}
+	memcpy(periodic->buffer + periodic->fill, buf, len);
+	periodic->fill += len;
+
+out:
+	streaming_mutex_unlock(&periodic->mutex);
+	return ret;
+}
+
+static int periodic_send_packet(const struct stream *s, void *p)
+{
+	periodic_t *periodic = (periodic_t *)s;
+
+	// zero-copy packets are not held back until the tick, the collected bytes go first to keep the order
+	streaming_mutex_lock(&periodic->mutex);
+	int ret = flush_locked(periodic);
+	if (ret < 0) {
+		s->downstream->pfree(s->downstream, p);
+	} else {
+		ret = s->downstream->streamp(s->downstream, p);
+	}
+	streaming_mutex_unlock(&periodic->mutex);
+	return ret;
+}
+
+static int periodic_backlog(const struct stream *s)
+{
+	const periodic_t *periodic = (const periodic_t *)s;
+	return stream_passthrough_backlog(s, periodic->fill);
+}
+
+static void histogram_add(uint32_t *histogram, uint32_t *max, uint64_t value_us)
+{
+	uint64_t bin = value_us / STREAMING_PERIODIC_BIN_US;
+
+	histogram[bin < STREAMING_PERIODIC_HISTOGRAM_BINS ? bin : STREAMING_PERIODIC_HISTOGRAM_BINS - 1]++;
+	if (value_us > *max) {
+		*max = value_us > UINT32_MAX ? UINT32_MAX : (uint32_t)value_us;
+	}
+}
+
+int streaming_periodic_init(periodic_t *periodic, const struct stream *downstream, void *buffer, size_t buffer_size,
+                            uint32_t period_us, const periodic_clock_t *clock)
+{
+	if (period_us == 0 || buffer_size == 0) {
+		return -1;
+	}
+
+	memset(periodic, 0, sizeof(*periodic));
+	stream_passthrough_init(&periodic->stream, &periodic->lock, downstream, periodic_send, periodic_send_packet,
+	                        periodic_backlog);
+	periodic->buffer = buffer;
+	periodic->capacity = buffer_size;
+	periodic->period_us = period_us;
+	if (clock != NULL) {
+		periodic->clock = *clock;
+	} else {
+		periodic->clock.now_us = os_now_us;
+		periodic->clock.sleep_until_us = os_sleep_until_us;
+	}
+	periodic->running = true;
+	streaming_mutex_init(&periodic->mutex);
+	return 0;
+}
+
+void streaming_periodic_set_tick(periodic_t *periodic, periodic_tick_callback *on_tick, void *context)
+{
+	streaming_mutex_lock(&periodic->mutex);
+	periodic->on_tick = on_tick;
+	periodic->context = context;
+	streaming_mutex_unlock(&periodic->mutex);
+}
+
+int streaming_periodic_cycle(periodic_t *periodic)
+{
+	periodic_clock_t *clock = &periodic->clock;
+
+	if (periodic->next_us == 0) {
+		// ticks are multiples of the period, so a period that is a multiple of the system tick stays aligned to it
+		uint64_t now = clock->now_us(clock->context);
+		periodic->next_us = (now / periodic->period_us + 1) * periodic->period_us;
+	}
+	clock->sleep_until_us(clock->context, periodic->next_us);
+
+	uint64_t start = clock->now_us(clock->context);
+	uint64_t lateness = start > periodic->next_us ? start - periodic->next_us : 0;
+
+	streaming_mutex_lock(&periodic->mutex);
+	uint64_t cycle = periodic->stats.cycles++;
+	histogram_add(periodic->stats.lateness, &periodic->stats.lateness_max_us, lateness);
+	if (cycle > 0) {
+		uint64_t interval = start - periodic->last_start_us;
+		uint64_t jitter = interval > periodic->period_us ? interval - periodic->period_us
+		                                                 : periodic->period_us - interval;
+		histogram_add(periodic->stats.jitter, &periodic->stats.jitter_max_us, jitter);
+	}
+	periodic->last_start_us = start;
+	periodic_tick_callback *on_tick = periodic->on_tick;
+	void *context = periodic->context;
+	streaming_mutex_unlock(&periodic->mutex);
+
+	// on_tick writes through periodic->stream, which takes the lock
+	if (on_tick != NULL) {
+		on_tick(periodic, cycle, context);
+	}
+
+	streaming_mutex_lock(&periodic->mutex);
+	if (periodic->fill == 0) {
+		periodic->stats.empty++;
+	}
+	int ret = flush_locked(periodic);
+	streaming_mutex_unlock(&periodic->mutex);
+	// the buffer may end inside a packet, the writers report the fill level between their packets
+	streaming_congestion_recalculate(&periodic->stream);
+
+	// a cycle that overran by more than a period skips the ticks it missed instead of sending them back to back
+	periodic->next_us += periodic->period_us;
+	uint64_t now = clock->now_us(clock->context);
+	uint32_t missed = 0;
+	while (now >= periodic->next_us + periodic->period_us) {
+		periodic->next_us += periodic->period_us;
+		missed++;
+	}
+	if (missed > 0) {
+		streaming_mutex_lock(&periodic->mutex);
+		periodic->stats.missed += missed;
+		streaming_mutex_unlock(&periodic->mutex);
+	}
+	return ret;
+}
+
+void streaming_periodic_run(periodic_t *periodic)
+{
+	while (periodic->running) {
+		int ret = streaming_periodic_cycle(periodic);
+		if (ret < 0) {
+			streaming_mutex_lock(&periodic->mutex);
+			periodic->error = ret;
+			streaming_mutex_unlock(&periodic->mutex);
+		}
+	}
+}
+
+void streaming_periodic_stop(periodic_t *periodic)
+{
+	periodic->running = false;
+}
+
+void streaming_periodic_stats(periodic_t *periodic, periodic_stats_t *stats)
+{
+	streaming_mutex_lock(&periodic->mutex);
+	*stats = periodic->stats;
+	streaming_mutex_unlock(&periodic->mutex);
+}
@@ -0,0 +1,114 @@
+#ifndef _STREAMING_PERIODIC_H_
+#define _STREAMING_PERIODIC_H_
+
+#include "stream_id.h"
+#include "streaming_config.h"
+#include "streaming_os.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * periodic transmit mode. Everything written through periodic->stream is collected and sent downstream once
+ * per period, on a fixed tick: tick n is due at n * period of the clock, so the cadence does not drift with the
+ * time the sends take and a period that is a multiple of the system tick is aligned to it. Before each flush
+ * the optional on_tick callback can serialize the data of the cycle, e.g. drain sample rings into periodic->stream.
+ *
+ * For every cycle the lateness (time the cycle started after its tick) and the jitter (deviation of the time
+ * between two cycle starts from the period) are recorded in histograms of STREAMING_PERIODIC_HISTOGRAM_BINS bins
+ * of STREAMING_PERIODIC_BIN_US, the last bin collects everything larger. Ticks that passed while a cycle
+ * overran are skipped and counted, they are not caught up.
+ *
+ * The clock can be replaced, e.g. by a simulated clock for testing, the default is the OS clock.
+ */
+
+struct periodic;
+
+typedef void periodic_tick_callback(struct periodic *periodic, uint64_t cycle, void *context);
+
+typedef struct {
+	uint64_t (*now_us)(void *context);
+	void (*sleep_until_us)(void *context, uint64_t time_us);
+	void *context;
+} periodic_clock_t;
+
+typedef struct {
+	uint64_t cycles;
+	// ticks skipped because a cycle overran
+	uint32_t missed;
+	// cycles without data
+	uint32_t empty;
+	// flushes between two ticks because the buffer was full
+	uint32_t early_flushes;
+	uint64_t bytes;
+	uint32_t lateness_max_us;
+	uint32_t jitter_max_us;
+	uint32_t lateness[STREAMING_PERIODIC_HISTOGRAM_BINS];
+	uint32_t jitter[STREAMING_PERIODIC_HISTOGRAM_BINS];
+} periodic_stats_t;
+
+typedef struct periodic {
+	// the collecting stream, must be the first member
+	struct stream stream;
+	struct stream_lock lock;
+	unsigned char *buffer;
+	size_t capacity;
+	size_t fill;
+	uint32_t period_us;
+	periodic_clock_t clock;
+	periodic_tick_callback *on_tick;
+	void *context;
+	// error of a flush by the periodic task, reported by the next write
+	int error;
+	bool running;
+	uint64_t next_us;
+	uint64_t last_start_us;
+	streaming_mutex_t mutex;
+	periodic_stats_t stats;
+} periodic_t;
+
+/**
+ * sets up the periodic transmit mode in front of downstream
+ *
+ * @param periodic the periodic transmitter to set up, must stay valid
+ * @param downstream the stream the data is written to on every tick
+ * @param buffer memory for the data of one cycle
+ * @param buffer_size size in bytes of buffer
+ * @param period_us period in microseconds, a multiple of the system tick on the target
+ * @param clock clock to use, NULL for the OS clock. Copied.
+ *
+ * @return <0 error, e.g. period 0
+ *         0  success
+ */
+int streaming_periodic_init(periodic_t *periodic, const struct stream *downstream, void *buffer, size_t buffer_size,
+                            uint32_t period_us, const periodic_clock_t *clock);
+
+/**
+ * sets the callback called at the start of every cycle, before the collected data is sent
+ */
+void streaming_periodic_set_tick(periodic_t *periodic, periodic_tick_callback *on_tick, void *context);
+
+/**
+ * runs one cycle: waits for the next tick, calls on_tick and sends the collected data
+ *
+ * @return <0 error of the downstream stream
+ *         0  success
+ */
+int streaming_periodic_cycle(periodic_t *periodic);
+
+/**
+ * body of the streaming task in periodic mode, runs cycles until streaming_periodic_stop
+ */
+void streaming_periodic_run(periodic_t *periodic);
+
+/**
+ * lets streaming_periodic_run return after the current cycle
+ */
+void streaming_periodic_stop(periodic_t *periodic);
+
+/**
+ * copies the statistics and histograms
+ */
+void streaming_periodic_stats(periodic_t *periodic, periodic_stats_t *stats);
+
+#endif
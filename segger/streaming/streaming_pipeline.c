@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "streaming_pipeline.h"
+#include "stream_passthrough.h"
+#include "streaming_congestion.h"
+#include <string.h>
+
+static void swap_locked(pipeline_t *pipeline)
+{
+	pipeline->ready = true;
+	pipeline->current ^= 1;
+	pipeline->fill[pipeline->current] = 0;
+	pipeline->swaps++;
+}
+
+/**
+ * passes the current buffer to the transmit task and continues with the other one
+ *
+ * @param wait whether to wait for the transmit task to finish the other buffer
+ *
+ * @return false if the transmit task is busy and wait is false
+ */
+static bool handover_locked(pipeline_t *pipeline, bool wait)
+{
+	if (pipeline->fill[pipeline->current] == 0) {
+		return true;
+	}
+	if (!pipeline->ready) {
+		swap_locked(pipeline);
+		streaming_wakeup_signal(&pipeline->filled);
+		return true;
+	}
+	if (!wait) {
+		return false;
+	}
+
+	// the transmit task swaps the buffers itself when it finishes, it does not wait for this task to wake up
+	uint32_t swaps = pipeline->swaps;
+	pipeline->stalls++;
+	pipeline->waiting = true;
+	while (pipeline->swaps == swaps) {
+		streaming_mutex_unlock(&pipeline->mutex);
+		streaming_wakeup_wait(&pipeline->drained, STREAMING_WAIT_FOREVER);
+		streaming_mutex_lock(&pipeline->mutex);
+	}
+	pipeline->waiting = false;
+	return true;
+}
+
+static int take_error_locked(pipeline_t *pipeline)
+{
+	int ret = pipeline->error;
+	pipeline->error = 0;
+	return ret;
+}
+
+static int pipeline_send(const struct stream *s, const char *buf, size_t len)
+{
+	pipeline_t *pipeline = (pipeline_t *)s;
+
+	streaming_mutex_lock(&pipeline->mutex);
+	if (pipeline->error < 0) {
+		int ret = take_error_locked(pipeline);
+		streaming_mutex_unlock(&pipeline->mutex);
+		return ret;
+	}
+
+	size_t done = 0;
+	while (done < len) {
+		size_t space = pipeline->capacity - pipeline->fill[pipeline->current];
+		if (space == 0) {
+			handover_locked(pipeline, true);
+			continue;
+		}
+		size_t n = len - done < space ? len - done : space;
+		memcpy(pipeline->buffers[pipeline->current] + pipeline->fill[pipeline->current], buf + done, n);
+		pipeline->fill[pipeline->current] += n;
+		done += n;
+	}
+	// keep the transmit task busy, the bytes are collected while it sends
+	handover_locked(pipeline, false);
+	streaming_mutex_unlock(&pipeline->mutex);
+	return (int)len;
+}
+
+static int pipeline_send_packet(const struct stream *s, void *p)
+{
+	pipeline_t *pipeline = (pipeline_t *)s;
+
+	// keep the order of the bytes
+	int ret = streaming_pipeline_flush(pipeline);
+	if (ret < 0) {
+		s->downstream->pfree(s->downstream, p);
+		return ret;
+	}
+	return s->downstream->streamp(s->downstream, p);
+}
+
+static int pipeline_backlog(const struct stream *s)
+{
+	const pipeline_t *pipeline = (const pipeline_t *)s;
+	return stream_passthrough_backlog(s, pipeline->fill[0] + pipeline->fill[1]);
+}
+
+int streaming_pipeline_init(pipeline_t *pipeline, const struct stream *downstream, void *buffer, size_t buffer_size)
+{
+	if (buffer_size < 2) {
+		return -1;
+	}
+
+	memset(pipeline, 0, sizeof(*pipeline));
+	stream_passthrough_init(&pipeline->stream, &pipeline->lock, downstream, pipeline_send, pipeline_send_packet,
+	                        pipeline_backlog);
+	pipeline->capacity = buffer_size / 2;
+	pipeline->buffers[0] = buffer;
+	pipeline->buffers[1] = (unsigned char *)buffer + pipeline->capacity;
+	pipeline->running = true;
+	streaming_mutex_init(&pipeline->mutex);
+	streaming_wakeup_init(&pipeline->filled);
+	streaming_wakeup_init(&pipeline->drained);
+	return 0;
+}
+
+void *streaming_pipeline_reserve(pipeline_t *pipeline, size_t size)
+{
+	void *ptr = NULL;
+
+	if (size > pipeline->capacity) {
+		return NULL;
+	}
+
+	streaming_mutex_lock(&pipeline->mutex);
+	if (pipeline->error == 0) {
+		if (pipeline->capacity - pipeline->fill[pipeline->current] < size) {
+			handover_locked(pipeline, true);
+		}
+		ptr = pipeline->buffers[pipeline->current] + pipeline->fill[pipeline->current];
+	}
+	streaming_mutex_unlock(&pipeline->mutex);
+	return ptr;
+}
+
+void streaming_pipeline_commit(pipeline_t *pipeline, size_t bytes)
+{
+	streaming_mutex_lock(&pipeline->mutex);
+	pipeline->fill[pipeline->current] += bytes;
+	handover_locked(pipeline, false);
+	streaming_mutex_unlock(&pipeline->mutex);
+}
+
+int streaming_pipeline_flush(pipeline_t *pipeline)
+{
+	streaming_mutex_lock(&pipeline->mutex);
+	handover_locked(pipeline, true);
+	while (pipeline->ready) {
+		streaming_mutex_unlock(&pipeline->mutex);
+		streaming_wakeup_wait(&pipeline->drained, STREAMING_WAIT_FOREVER);
+		streaming_mutex_lock(&pipeline->mutex);
+	}
+	int ret = take_error_locked(pipeline);
+	streaming_mutex_unlock(&pipeline->mutex);
+	return ret;
+}
+
+void streaming_pipeline_run(pipeline_t *pipeline)
+{
+	for (;;) {
+		streaming_mutex_lock(&pipeline->mutex);
+		if (!pipeline->ready) {
+			bool running = pipeline->running;
+			streaming_mutex_unlock(&pipeline->mutex);
+			if (!running) {
+				return;
+			}
+			streaming_wakeup_wait(&pipeline->filled, STREAMING_WAIT_FOREVER);
+			continue;
+		}
+		// the serializing task does not touch the other buffer while it is ready
+		unsigned int index = pipeline->current ^ 1;
+		size_t length = pipeline->fill[index];
+		streaming_mutex_unlock(&pipeline->mutex);
+
+		// the bytes count towards the backlog of the pipeline until they are sent
+		const struct stream *downstream = pipeline->stream.downstream;
+		int ret = downstream->stream(downstream, (const char *)pipeline->buffers[index], length);
+
+		streaming_mutex_lock(&pipeline->mutex);
+		if (ret < 0) {
+			// the bytes are dropped, the stream is broken anyway
+			pipeline->error = ret;
+		}
+		pipeline->fill[index] = 0;
+		pipeline->ready = false;
+		if (pipeline->waiting) {
+			// the serializing task waits with a full buffer, take it right away
+			swap_locked(pipeline);
+		}
+		streaming_mutex_unlock(&pipeline->mutex);
+		streaming_wakeup_signal(&pipeline->drained);
+		// a buffer may end inside a packet, the serializing task reports the fill level between its packets
+		streaming_congestion_recalculate(&pipeline->stream);
+	}
+}
+
+void streaming_pipeline_stop(pipeline_t *pipeline)
+{
+	streaming_mutex_lock(&pipeline->mutex);
+	pipeline->running = false;
+	streaming_mutex_unlock(&pipeline->mutex);
+	streaming_wakeup_signal(&pipeline->filled);
+}
@@ -0,0 +1,96 @@
+#ifndef _STREAMING_PIPELINE_H_
+#define _STREAMING_PIPELINE_H_
+
+#include "stream_id.h"
+#include "streaming_os.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * a pipeline splits sending into two stages running in different tasks. The serializing task writes through
+ * pipeline->stream (or serializes in place, see streaming_pipeline_reserve) into one of two buffers, while the
+ * transmit task running streaming_pipeline_run writes the other buffer to the downstream stream. The buffers
+ * are swapped as soon as the transmit task is idle, so serialization and the blocking send overlap. The
+ * serializing task only waits when its buffer is full and the transmit task is still busy.
+ *
+ * There must be one serializing task. Zero-copy packets are passed downstream by the serializing task after
+ * all buffered bytes are sent.
+ */
+
+typedef struct {
+	// the serializing stream, must be the first member
+	struct stream stream;
+	struct stream_lock lock;
+	unsigned char *buffers[2];
+	size_t capacity;
+	size_t fill[2];
+	// buffer written by the serializing task
+	unsigned int current;
+	// the other buffer belongs to the transmit task until it is sent
+	bool ready;
+	// the serializing task waits for the transmit task to take its full buffer
+	bool waiting;
+	// error of the transmit task, reported by the next write
+	int error;
+	bool running;
+	streaming_mutex_t mutex;
+	// serializing task -> transmit task: a buffer is ready
+	streaming_wakeup_t filled;
+	// transmit task -> serializing task: the buffer is sent
+	streaming_wakeup_t drained;
+	// statistics
+	uint32_t swaps;
+	// swaps that had to wait for the transmit task
+	uint32_t stalls;
+} pipeline_t;
+
+/**
+ * sets up a pipeline in front of downstream
+ *
+ * @param pipeline the pipeline to set up, must stay valid
+ * @param downstream the stream the transmit task writes to
+ * @param buffer memory for both buffers, split in half
+ * @param buffer_size size in bytes of buffer
+ *
+ * @return <0 error, buffer too small
+ *         0  success
+ */
+int streaming_pipeline_init(pipeline_t *pipeline, const struct stream *downstream, void *buffer, size_t buffer_size);
+
+/**
+ * serializing task: space for serializing in place into the current buffer. Hands the buffer over first if
+ * less than size bytes are free.
+ *
+ * @param pipeline the pipeline
+ * @param size bytes needed, at most half of the buffer
+ *
+ * @return pointer to at least size free bytes, NULL on an error of the transmit task or if size is too large
+ */
+void *streaming_pipeline_reserve(pipeline_t *pipeline, size_t size);
+
+/**
+ * serializing task: appends the first bytes of the reserved space, e.g. the return value of a serialization
+ * function
+ */
+void streaming_pipeline_commit(pipeline_t *pipeline, size_t bytes);
+
+/**
+ * serializing task: waits until all bytes written so far are sent
+ *
+ * @return <0 error of the downstream stream
+ *         0  success
+ */
+int streaming_pipeline_flush(pipeline_t *pipeline);
+
+/**
+ * body of the transmit task, sends buffers until streaming_pipeline_stop
+ */
+void streaming_pipeline_run(pipeline_t *pipeline);
+
+/**
+ * lets streaming_pipeline_run return after sending the buffer that is ready
+ */
+void streaming_pipeline_stop(pipeline_t *pipeline);
+
+#endif
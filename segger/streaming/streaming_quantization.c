@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "streaming_quantization.h"
+#include "streaming_endian.h"
+#include <string.h>
+
+// samples are quantized in blocks, so the conversion loops run on plain arrays
+#define QUANTIZATION_BLOCK_SIZE 64
+
+bool quantization_active(const signal_definition_t *def)
+{
+	if (def->quantization == NULL || def->rule != signal_explicit_rule || def->range == NULL) {
+		return false;
+	}
+	if (def->datatype != signal_type_real32 && def->datatype != signal_type_real64) {
+		return false;
+	}
+	if (def->quantization->datatype != signal_type_int16 && def->quantization->datatype != signal_type_int32) {
+		return false;
+	}
+	return def->range->high > def->range->low;
+}
+
+double quantization_limit(const signal_definition_t *def)
+{
+	return def->quantization->datatype == signal_type_int16 ? INT16_MAX : INT32_MAX;
+}
+
+void quantization_params(const signal_definition_t *def, double *scale, double *offset)
+{
+	*offset = (def->range->high + def->range->low) / 2;
+	*scale = (def->range->high - def->range->low) / (2 * quantization_limit(def));
+}
+
+static void load_block(signal_data_type_e datatype, double *dst, const unsigned char *src, size_t stride,
+                       size_t num)
+{
+	if (datatype == signal_type_real32) {
+		for (size_t i = 0; i < num; i++) {
+			float v;
+			memcpy(&v, src + i * stride, sizeof(v));
+			dst[i] = v;
+		}
+	} else {
+		for (size_t i = 0; i < num; i++) {
+			memcpy(&dst[i], src + i * stride, sizeof(dst[i]));
+		}
+	}
+}
+
+void quantization_run(const signal_definition_t *def, unsigned char *dst, const void *src, size_t stride,
+                      size_t num)
+{
+	const unsigned char *src_ptr = src;
+	double block[QUANTIZATION_BLOCK_SIZE];
+	int32_t q32[QUANTIZATION_BLOCK_SIZE];
+	int16_t q16[QUANTIZATION_BLOCK_SIZE];
+	double scale;
+	double offset;
+	double limit = quantization_limit(def);
+	bool is_int16 = def->quantization->datatype == signal_type_int16;
+
+	quantization_params(def, &scale, &offset);
+	double inv_scale = 1 / scale;
+
+	while (num > 0) {
+		size_t n = num < QUANTIZATION_BLOCK_SIZE ? num : QUANTIZATION_BLOCK_SIZE;
+		load_block(def->datatype, block, src_ptr, stride, n);
+
+		// branch free clamp and round half away from zero, the compiler can vectorize this loop
+		for (size_t i = 0; i < n; i++) {
+			double x = (block[i] - offset) * inv_scale;
+			x = x == x ? x : 0; // NaN
+			x = x < -limit ? -limit : x;
+			x = x > limit ? limit : x;
+			q32[i] = (int32_t)(x + (x < 0 ? -0.5 : 0.5));
+		}
+
+		if (is_int16) {
+			for (size_t i = 0; i < n; i++) {
+				q16[i] = (int16_t)q32[i];
+			}
+			streaming_copy_le16(dst, q16, n);
+			dst += n * sizeof(int16_t);
+		} else {
+			streaming_copy_le32(dst, q32, n);
+			dst += n * sizeof(int32_t);
+		}
+
+		src_ptr += n * stride;
+		num -= n;
+	}
+}
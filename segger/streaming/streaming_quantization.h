@@ -0,0 +1,44 @@
+#ifndef _STREAMING_QUANTIZATION_H_
+#define _STREAMING_QUANTIZATION_H_
+
+#include "streaming_signals.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * explicit signals of real datatypes can be transmitted as int16 or int32 samples. The range of the signal
+ * is mapped symmetrically to [-max, max] of the integer type, values outside of the range are clamped.
+ * The advertised dataType, range and postScaling are rewritten, so clients reconstruct the real values.
+ */
+
+/**
+ * whether the samples of the signal are quantized. This requires an explicit signal of type real32 or real64,
+ * a quantization object with datatype int16 or int32 and a range with high > low.
+ */
+bool quantization_active(const signal_definition_t *def);
+
+/**
+ * datatype of the samples on the wire
+ */
+static inline signal_data_type_e signal_wire_datatype(const signal_definition_t *def)
+{
+	return quantization_active(def) ? def->quantization->datatype : def->datatype;
+}
+
+/**
+ * largest value of the quantized samples, the smallest value is its negation
+ */
+double quantization_limit(const signal_definition_t *def);
+
+/**
+ * the quantized sample q represents the real value q * scale + offset
+ */
+void quantization_params(const signal_definition_t *def, double *scale, double *offset);
+
+/**
+ * quantizes num samples at src, which are stride bytes apart, and writes them to dst in little endian byte order
+ */
+void quantization_run(const signal_definition_t *def, unsigned char *dst, const void *src, size_t stride,
+                      size_t num);
+
+#endif
@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "streaming_sample_ring.h"
+#include "stream_id.h"
+#include "streaming_congestion.h"
+#include "streaming_packet.h"
+#include <string.h>
+
+int streaming_sample_ring_init(sample_ring_t *ring, signal_t *signal, void *buffer, size_t buffer_size,
+                               sample_ring_overflow_e overflow)
+{
+	size_t sample_size = openDAQ_streaming_source_sample_size(signal);
+
+	if (signal->definition->rule != signal_explicit_rule || sample_size == 0) {
+		return -1;
+	}
+
+	size_t num = buffer_size / sample_size;
+	uint32_t capacity = 1;
+	if (num == 0) {
+		return -1;
+	}
+	while (capacity <= num / 2 && capacity < UINT32_MAX / 2 + 1) {
+		capacity <<= 1;
+	}
+
+	ring->signal = signal;
+	ring->buffer = buffer;
+	ring->sample_size = sample_size;
+	ring->capacity = capacity;
+	ring->overflow = overflow;
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+	atomic_init(&ring->dropped, 0);
+	atomic_init(&ring->overflows, 0);
+	atomic_init(&ring->gap_head, 0);
+	atomic_init(&ring->gap_tail, 0);
+	ring->discarded = 0;
+	ring->consumed = 0;
+	ring->gap = 0;
+	return 0;
+}
+
+static void count_dropped(sample_ring_t *ring, uint32_t num)
+{
+	// only the producer writes the counters
+	atomic_store_explicit(&ring->dropped, atomic_load_explicit(&ring->dropped, memory_order_relaxed) + num,
+	                      memory_order_relaxed);
+	atomic_store_explicit(&ring->overflows, atomic_load_explicit(&ring->overflows, memory_order_relaxed) + 1,
+	                      memory_order_relaxed);
+}
+
+/**
+ * producer: hands the samples discarded in front of the head over to the consumer, before samples follow them
+ *
+ * @return false if all gaps are in use
+ */
+static bool publish_gap(sample_ring_t *ring, uint32_t head)
+{
+	if (ring->discarded == 0) {
+		return true;
+	}
+
+	uint32_t gap_head = atomic_load_explicit(&ring->gap_head, memory_order_relaxed);
+	uint32_t gap_tail = atomic_load_explicit(&ring->gap_tail, memory_order_acquire);
+	if (gap_head - gap_tail == STREAMING_SAMPLE_RING_GAPS) {
+		return false;
+	}
+	ring->gaps[gap_head % STREAMING_SAMPLE_RING_GAPS].position = head;
+	ring->gaps[gap_head % STREAMING_SAMPLE_RING_GAPS].count = ring->discarded;
+	atomic_store_explicit(&ring->gap_head, gap_head + 1, memory_order_release);
+	ring->discarded = 0;
+	return true;
+}
+
+uint32_t streaming_sample_ring_push(sample_ring_t *ring, const void *src, uint32_t num)
+{
+	const unsigned char *src_ptr = src;
+	uint32_t mask = ring->capacity - 1;
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	uint32_t discarded = 0;
+
+	if (ring->overflow == sample_ring_drop_newest) {
+		uint32_t space = ring->capacity - (head - tail);
+		if (num > space) {
+			discarded = num - space;
+			num = space;
+		}
+		if (num > 0 && !publish_gap(ring, head)) {
+			// the gap in front of the head cannot be signalled, so it grows until the consumer catches up
+			discarded += num;
+			num = 0;
+		}
+		ring->discarded += discarded;
+	} else {
+		if (num > ring->capacity) {
+			// only the newest samples of src survive, the others take their positions and are overwritten at once,
+			// so the consumer sees them dropped in front of the tail
+			uint32_t skip = num - ring->capacity;
+			src_ptr += (size_t)skip * ring->sample_size;
+			head += skip;
+			num = ring->capacity;
+		}
+		// move the tail past the oldest samples. The consumer notices this when it commits its drain.
+		for (;;) {
+			uint32_t fill = head - tail;
+			if (fill + num <= ring->capacity) {
+				break;
+			}
+			if (atomic_compare_exchange_weak_explicit(&ring->tail, &tail, tail + (fill + num - ring->capacity),
+			                                          memory_order_acq_rel, memory_order_acquire)) {
+				discarded = fill + num - ring->capacity;
+				break;
+			}
+		}
+	}
+
+	if (num > 0) {
+		uint32_t start = head & mask;
+		uint32_t first = ring->capacity - start < num ? ring->capacity - start : num;
+		memcpy(ring->buffer + (size_t)start * ring->sample_size, src_ptr, (size_t)first * ring->sample_size);
+		memcpy(ring->buffer, src_ptr + (size_t)first * ring->sample_size, (size_t)(num - first) * ring->sample_size);
+		atomic_store_explicit(&ring->head, head + num, memory_order_release);
+	}
+	if (discarded > 0) {
+		count_dropped(ring, discarded);
+	}
+	return discarded;
+}
+
+/**
+ * consumer: takes the gaps published in front of the tail, and limits num to the samples before the next gap
+ */
+static uint32_t take_gaps(sample_ring_t *ring, uint32_t tail, uint32_t num)
+{
+	uint32_t gap_tail = atomic_load_explicit(&ring->gap_tail, memory_order_relaxed);
+	uint32_t gap_head = atomic_load_explicit(&ring->gap_head, memory_order_acquire);
+
+	for (; gap_tail != gap_head; gap_tail++) {
+		sample_ring_gap_t *gap = &ring->gaps[gap_tail % STREAMING_SAMPLE_RING_GAPS];
+		if (gap->position != tail) {
+			// the samples up to the gap go into this packet
+			num = gap->position - tail < num ? gap->position - tail : num;
+			break;
+		}
+		ring->gap += gap->count;
+	}
+	atomic_store_explicit(&ring->gap_tail, gap_tail, memory_order_release);
+	return num;
+}
+
+int streaming_sample_ring_drain(sample_ring_t *ring, void *dst, size_t dst_size)
+{
+	signal_t *signal = ring->signal;
+	uint32_t mask = ring->capacity - 1;
+	unsigned char *dst_ptr = dst;
+	size_t len = 0;
+
+	for (;;) {
+		uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+		uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		uint32_t num = head - tail;
+
+		if (num > ring->capacity) {
+			// the producer moved the tail past samples it skips, the head follows with its push
+			return len;
+		}
+		if (!signal_has_subscription(signal)) {
+			if (atomic_compare_exchange_strong_explicit(&ring->tail, &tail, head, memory_order_acq_rel,
+			                                            memory_order_relaxed)) {
+				// the gaps are published before the samples behind them, all of them are discarded as well
+				atomic_store_explicit(&ring->gap_tail, atomic_load_explicit(&ring->gap_head, memory_order_acquire),
+				                      memory_order_release);
+				ring->consumed = head;
+				ring->gap = 0;
+				return 0;
+			}
+			continue;
+		}
+
+		// the producer moved the tail past the oldest samples
+		ring->gap += tail - ring->consumed;
+		ring->consumed = tail;
+		num = take_gaps(ring, tail, num);
+		if (num == 0) {
+			return len;
+		}
+
+		// room for the start values of the domain, in case samples are dropped below
+		size_t gap_size = openDAQ_streaming_gap_size(signal);
+		size_t space = dst_size - len > gap_size ? dst_size - len - gap_size : 0;
+		unsigned int max_samples = openDAQ_streaming_explicit_max_samples(signal, space);
+		if (max_samples == 0) {
+			return len > 0 ? (int)len : -1;
+		}
+		if (num > max_samples) {
+			if (streaming_congestion_admit(signal) == congestion_drop) {
+				// keep the newest samples that fit into one packet
+				uint32_t drop = num - max_samples;
+				if (!atomic_compare_exchange_strong_explicit(&ring->tail, &tail, tail + drop, memory_order_acq_rel,
+				                                             memory_order_relaxed)) {
+					continue;
+				}
+				streaming_congestion_dropped(signal->stream, drop);
+				tail += drop;
+				ring->gap += drop;
+				ring->consumed = tail;
+			}
+			num = max_samples;
+		}
+
+		if (ring->gap > 0) {
+			// stays in dst even if the samples below are overwritten, the gap has been signalled
+			int ret = openDAQ_streaming_serialize_gap(dst_ptr + len, dst_size - len, signal, ring->gap);
+			if (ret < 0) {
+				return ret;
+			}
+			len += ret;
+			ring->gap = 0;
+		}
+
+		uint32_t start = tail & mask;
+		uint32_t first = ring->capacity - start < num ? ring->capacity - start : num;
+		// serializing advances the decimation and the sample index, both are undone if the samples were overwritten
+		decimation_t decimation = signal->decimation;
+		uint64_t sample_index = signal->sample_index;
+		int ret = openDAQ_streaming_serialize_explicit_signal_ring(dst_ptr + len, dst_size - len, signal,
+		                                                           ring->buffer + (size_t)start * ring->sample_size,
+		                                                           first, ring->buffer, num - first, 0);
+		if (ret < 0) {
+			return ret;
+		}
+		// the producer moves the tail before it overwrites samples, an unchanged tail validates the copy
+		if (atomic_compare_exchange_strong_explicit(&ring->tail, &tail, tail + num, memory_order_acq_rel,
+		                                            memory_order_relaxed)) {
+			ring->consumed = tail + num;
+			return len + ret;
+		}
+		// the next round signals the overwritten samples as gap and serializes the samples behind it
+		signal->decimation = decimation;
+		signal->sample_index = sample_index;
+	}
+}
+
+int streaming_sample_ring_send(sample_ring_t *ring, void *buf, size_t buf_size)
+{
+	int sent = 0;
+
+	for (;;) {
+		int ret = streaming_sample_ring_drain(ring, buf, buf_size);
+		if (ret <= 0) {
+			return ret < 0 ? ret : sent;
+		}
+		const struct stream *stream = ring->signal->stream;
+		if (stream == NULL) {
+			// unsubscribed meanwhile
+			return sent;
+		}
+		streaming_congestion_begin(stream, ret);
+		int err = stream->stream(stream, buf, ret);
+		streaming_congestion_end(stream, ret);
+		if (err < 0) {
+			return err;
+		}
+		sent += ret;
+	}
+}
+
+void streaming_sample_ring_stats(sample_ring_t *ring, sample_ring_stats_t *stats)
+{
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+	// the tail runs ahead of the head while the producer skips samples
+	stats->fill = head - tail <= ring->capacity ? head - tail : 0;
+	stats->capacity = ring->capacity;
+	stats->dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+	stats->overflows = atomic_load_explicit(&ring->overflows, memory_order_relaxed);
+}
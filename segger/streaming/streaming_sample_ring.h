@@ -0,0 +1,132 @@
+#ifndef _STREAMING_SAMPLE_RING_H_
+#define _STREAMING_SAMPLE_RING_H_
+
+#include "streaming_config.h"
+#include "streaming_signals.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * a sample ring decouples the acquisition from the network. The acquisition, possibly an ISR, pushes the samples
+ * of an explicit signal into the ring without ever blocking, a streaming task drains the ring, serializes and
+ * sends the samples. There must be exactly one producer and one consumer per ring, no locks are taken.
+ *
+ * The positions are free running sample counters, the capacity is a power of 2.
+ *
+ * Discarded samples leave a gap in the samples the client receives. The consumer signals every gap in front of the
+ * next sample it sends, see openDAQ_streaming_serialize_gap, so the client keeps stamping the samples correctly.
+ */
+
+typedef enum {
+	// samples that do not fit are discarded, the ring keeps the oldest samples. Pushing is wait-free. While
+	// STREAMING_SAMPLE_RING_GAPS gaps wait for the consumer, all samples are discarded.
+	sample_ring_drop_newest,
+	// the oldest samples are discarded to make room, the ring keeps the newest samples. Pushing is lock-free,
+	// a retry only happens if the consumer freed space at the same time.
+	sample_ring_drop_oldest,
+} sample_ring_overflow_e;
+
+typedef struct {
+	// position of the first sample behind the gap
+	uint32_t position;
+	// samples discarded in front of position
+	uint32_t count;
+} sample_ring_gap_t;
+
+typedef struct {
+	signal_t *signal;
+	unsigned char *buffer;
+	size_t sample_size;
+	uint32_t capacity;
+	sample_ring_overflow_e overflow;
+	// written by the producer
+	atomic_uint_least32_t head;
+	// written by the consumer, and by the producer when dropping the oldest samples
+	atomic_uint_least32_t tail;
+	// overflow statistics, written by the producer
+	atomic_uint_least32_t dropped;
+	atomic_uint_least32_t overflows;
+	// sample_ring_drop_newest only: gaps in the middle of the ring, published by the producer
+	sample_ring_gap_t gaps[STREAMING_SAMPLE_RING_GAPS];
+	atomic_uint_least32_t gap_head;
+	atomic_uint_least32_t gap_tail;
+	// producer only: samples discarded in front of the head, published with the next samples pushed
+	uint32_t discarded;
+	// consumer only: the tail the consumer left, the producer moves the tail beyond it when dropping the oldest
+	uint32_t consumed;
+	// consumer only: samples dropped in front of the tail, signalled with the next packet
+	uint32_t gap;
+} sample_ring_t;
+
+typedef struct {
+	// samples waiting in the ring
+	uint32_t fill;
+	uint32_t capacity;
+	// samples discarded because the ring was full
+	uint32_t dropped;
+	// pushes that discarded samples
+	uint32_t overflows;
+} sample_ring_stats_t;
+
+/**
+ * sets up a sample ring for an explicit signal
+ *
+ * @param ring the ring to set up, must stay valid
+ * @param signal the explicit signal whose samples are pushed
+ * @param buffer memory for the samples, the capacity is the largest power of 2 of samples that fits
+ * @param buffer_size size in bytes of buffer
+ * @param overflow what to discard when the ring is full
+ *
+ * @return <0 error, e.g. not an explicit signal or buffer too small
+ *         0  success
+ */
+int streaming_sample_ring_init(sample_ring_t *ring, signal_t *signal, void *buffer, size_t buffer_size,
+                               sample_ring_overflow_e overflow);
+
+/**
+ * producer: copies num samples into the ring, never blocks
+ *
+ * @param ring the ring
+ * @param src contiguous samples of the signal
+ * @param num number of samples at src
+ *
+ * @return number of samples of src discarded
+ */
+uint32_t streaming_sample_ring_push(sample_ring_t *ring, const void *src, uint32_t num);
+
+/**
+ * consumer: serializes as many samples of the ring as fit into one packet. Samples pushed while the signal is
+ * not subscribed are discarded. If samples were dropped in front of the packet, the new start values of the
+ * domain are written first.
+ *
+ * @param ring the ring
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ *
+ * @return <0    error, e.g. dst cannot hold a single sample
+ *         0     ring empty or signal not subscribed, nothing written
+ *         else  number of bytes written
+ */
+int streaming_sample_ring_drain(sample_ring_t *ring, void *dst, size_t dst_size);
+
+/**
+ * consumer: drains the ring packet by packet through buf and sends the packets through the stream of the
+ * subscribed signal, until the ring is empty. May block in the stream.
+ *
+ * @param ring the ring
+ * @param buf buffer for one packet
+ * @param buf_size size in bytes of buf
+ *
+ * @return <0    error of serializing or sending
+ *         else  number of bytes sent
+ */
+int streaming_sample_ring_send(sample_ring_t *ring, void *buf, size_t buf_size);
+
+/**
+ * reads the fill level and the overflow counters, may be called from any task
+ */
+void streaming_sample_ring_stats(sample_ring_t *ring, sample_ring_stats_t *stats);
+
+#endif
@@ -0,0 +1,530 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "streaming_scheduler.h"
+#include "stream_passthrough.h"
+#include "streaming_congestion.h"
+#include "streaming_packet.h"
+#include <string.h>
+
+// the incoming packet is dropped because its queue is full
+#define SCHEDULER_CLASS_DISCARD SCHEDULER_NUM_CLASSES
+
+// packets are queued in parts of at most this size
+#define SCHEDULER_PART_SIZE                                                                                         \
+	(STREAMING_SCHEDULER_PACKET_SIZE < STREAMING_SCHEDULER_QUEUE_SIZE ? STREAMING_SCHEDULER_PACKET_SIZE             \
+	                                                                  : STREAMING_SCHEDULER_QUEUE_SIZE)
+
+/**
+ * meta information of the connection is control traffic. Data and the meta information of a signal share the
+ * class of the signal, so its meta information stays in order with its samples.
+ */
+static scheduler_class_e class_of_packet(const streaming_packet_info_t *info)
+{
+	if (info->packet_type != TYPE_DATA && info->signal_number == 0) {
+		return scheduler_class_control;
+	}
+	signal_t *signal = signal_get_by_signal_no(info->signal_number);
+	if (signal != NULL && signal->definition->priority == priority_high) {
+		return scheduler_class_high;
+	}
+	return scheduler_class_bulk;
+}
+
+/**
+ * whether bytes fit into the queue. A new part needs an entry of its own, an incomplete part has one already.
+ */
+static bool queue_has_room(const scheduler_queue_t *queue, size_t bytes)
+{
+	return queue->used + bytes <= sizeof(queue->data) &&
+	       (queue->used > queue->complete || queue->num_packets < STREAMING_SCHEDULER_QUEUE_PACKETS);
+}
+
+/**
+ * waits for the flush task to send a part, the queue lock is released meanwhile
+ *
+ * @return <0 the scheduler stopped
+ *         0  success
+ */
+static int wait_for_room(scheduler_t *scheduler)
+{
+	streaming_mutex_unlock(&scheduler->mutex);
+	streaming_wakeup_wait(&scheduler->room, STREAMING_SCHEDULER_IDLE_MS);
+	streaming_mutex_lock(&scheduler->mutex);
+	return scheduler->running ? 0 : -1;
+}
+
+/**
+ * opens a new packet in the queue of its class, the headers collected so far become its first bytes
+ *
+ * @return <0 queue full, the packet is discarded
+ *         0  success
+ */
+static int open_packet(scheduler_t *scheduler, const streaming_packet_info_t *info)
+{
+	scheduler_incoming_t *incoming = &scheduler->incoming;
+	scheduler_class_e class = class_of_packet(info);
+	scheduler_queue_t *queue = &scheduler->queues[class];
+	size_t first = info->length < SCHEDULER_PART_SIZE ? info->length : SCHEDULER_PART_SIZE;
+
+	incoming->open = true;
+	incoming->remaining = info->length - incoming->header_used;
+	incoming->class = SCHEDULER_CLASS_DISCARD;
+	while (!queue_has_room(queue, first)) {
+		// meta information is never dropped, its writer waits for the flush task
+		if (info->packet_type == TYPE_DATA || wait_for_room(scheduler) < 0) {
+			scheduler->stats[class].rejected++;
+			return -1;
+		}
+	}
+
+	incoming->class = class;
+	queue->partial_us = streaming_os_time_us();
+	memcpy(queue->data + queue->used, incoming->header, incoming->header_used);
+	queue->used += incoming->header_used;
+	return 0;
+}
+
+static void close_part(scheduler_t *scheduler, scheduler_queue_t *queue, bool last)
+{
+	scheduler_packet_t *packet = &queue->packets[queue->num_packets++];
+	packet->length = queue->used - queue->complete;
+	packet->queued_us = queue->partial_us;
+	packet->last = last;
+	queue->complete = queue->used;
+	streaming_wakeup_signal(&scheduler->wakeup);
+}
+
+static void close_packet(scheduler_t *scheduler)
+{
+	scheduler_incoming_t *incoming = &scheduler->incoming;
+
+	if (incoming->class != SCHEDULER_CLASS_DISCARD) {
+		close_part(scheduler, &scheduler->queues[incoming->class], true);
+	}
+	incoming->open = false;
+	incoming->header_used = 0;
+}
+
+/**
+ * queues bytes of the open packet, as many as fit into the current part
+ *
+ * @return number of bytes taken, 0 if the writer has to wait for room
+ */
+static size_t queue_bytes(scheduler_t *scheduler, const unsigned char *ptr, size_t len)
+{
+	scheduler_incoming_t *incoming = &scheduler->incoming;
+	size_t n = len < incoming->remaining ? len : incoming->remaining;
+
+	if (incoming->class == SCHEDULER_CLASS_DISCARD) {
+		return n;
+	}
+
+	scheduler_queue_t *queue = &scheduler->queues[incoming->class];
+	if (!queue_has_room(queue, 1)) {
+		return 0;
+	}
+	if (queue->used == queue->complete) {
+		queue->partial_us = streaming_os_time_us();
+	}
+	size_t part = queue->used - queue->complete;
+	size_t room = sizeof(queue->data) - queue->used;
+	if (n > room) {
+		n = room;
+	}
+	if (n > SCHEDULER_PART_SIZE - part) {
+		n = SCHEDULER_PART_SIZE - part;
+	}
+	memcpy(queue->data + queue->used, ptr, n);
+	queue->used += n;
+	if (n < incoming->remaining &&
+	    (queue->used - queue->complete == SCHEDULER_PART_SIZE || queue->used == sizeof(queue->data))) {
+		// the packet continues in the next part, the flush task can start sending this one
+		close_part(scheduler, queue, false);
+	}
+	return n;
+}
+
+static int append_locked(scheduler_t *scheduler, const char *buf, size_t len)
+{
+	scheduler_incoming_t *incoming = &scheduler->incoming;
+	const unsigned char *ptr = (const unsigned char *)buf;
+	int ret = 0;
+
+	while (len > 0) {
+		if (!incoming->open) {
+			// collect the headers byte by byte, so no byte of the next packet is taken
+			streaming_packet_info_t info;
+			incoming->header[incoming->header_used++] = *ptr++;
+			len--;
+			if (openDAQ_streaming_parse_header(incoming->header, incoming->header_used, &info)) {
+				if (open_packet(scheduler, &info) < 0) {
+					ret = -1;
+				}
+				if (incoming->remaining == 0) {
+					close_packet(scheduler);
+				}
+			}
+			continue;
+		}
+
+		size_t n = queue_bytes(scheduler, ptr, len);
+		if (n == 0) {
+			if (wait_for_room(scheduler) < 0) {
+				// the scheduler stopped, the rest of the packet is dropped
+				incoming->class = SCHEDULER_CLASS_DISCARD;
+				ret = -1;
+			}
+			continue;
+		}
+		ptr += n;
+		len -= n;
+		incoming->remaining -= n;
+		if (incoming->remaining == 0) {
+			close_packet(scheduler);
+		}
+	}
+	return ret;
+}
+
+static int scheduler_send(const struct stream *s, const char *buf, size_t len)
+{
+	scheduler_t *scheduler = (scheduler_t *)s;
+
+	streaming_mutex_lock(&scheduler->mutex);
+	int ret = append_locked(scheduler, buf, len);
+	streaming_mutex_unlock(&scheduler->mutex);
+	return ret < 0 ? ret : (int)len;
+}
+
+static int scheduler_send_segments(const struct stream *s, const stream_segment_t *segments, unsigned int num)
+{
+	scheduler_t *scheduler = (scheduler_t *)s;
+	int total = 0;
+	int ret = 0;
+
+	// the segments of one call belong together, e.g. header and payload of a meta packet
+	streaming_mutex_lock(&scheduler->mutex);
+	for (unsigned int i = 0; i < num; i++) {
+		if (append_locked(scheduler, segments[i].pBuffer, segments[i].NumBytes) < 0) {
+			ret = -1;
+		}
+		total += segments[i].NumBytes;
+	}
+	streaming_mutex_unlock(&scheduler->mutex);
+	return ret < 0 ? ret : total;
+}
+
+static void account(scheduler_t *scheduler, scheduler_class_e class, size_t length, uint64_t since_us)
+{
+	scheduler_class_stats_t *stats = &scheduler->stats[class];
+	uint64_t latency = streaming_os_time_us() - since_us;
+
+	stats->packets++;
+	stats->bytes += length;
+	stats->latency_sum_us += latency;
+	if (latency > stats->latency_max_us) {
+		stats->latency_max_us = latency > UINT32_MAX ? UINT32_MAX : (uint32_t)latency;
+	}
+}
+
+/**
+ * sends the oldest complete packet of a queue, send_mutex must be held. Only the scheduler task removes packets,
+ * producers append behind them, so the parts are sent without holding the queue lock. The parts of a packet go out
+ * back to back, the task waits for the writer of a large packet to queue the next part.
+ */
+static int send_packet_locked(scheduler_t *scheduler, scheduler_source_t *source)
+{
+	const struct stream *downstream = scheduler->stream.downstream;
+	scheduler_queue_t *queue = source->queue;
+	uint64_t queued_us = 0;
+	size_t length = 0;
+	bool last = false;
+	int ret = 0;
+
+	while (!last) {
+		streaming_mutex_lock(&scheduler->mutex);
+		if (queue->num_packets == 0) {
+			streaming_mutex_unlock(&scheduler->mutex);
+			if (!scheduler->running) {
+				ret = -1;
+				break;
+			}
+			streaming_wakeup_wait(&scheduler->wakeup, STREAMING_SCHEDULER_IDLE_MS);
+			continue;
+		}
+		scheduler_packet_t packet = queue->packets[0];
+		streaming_mutex_unlock(&scheduler->mutex);
+
+		if (length == 0) {
+			queued_us = packet.queued_us;
+		}
+		if (ret >= 0) {
+			// after an error the rest of the packet is dropped, the stream is broken anyway
+			ret = downstream->stream(downstream, (const char *)queue->data, packet.length);
+		}
+		length += packet.length;
+		last = packet.last;
+
+		streaming_mutex_lock(&scheduler->mutex);
+		memmove(queue->data, queue->data + packet.length, queue->used - packet.length);
+		queue->used -= packet.length;
+		queue->complete -= packet.length;
+		queue->num_packets--;
+		memmove(queue->packets, queue->packets + 1, queue->num_packets * sizeof(queue->packets[0]));
+		if (last) {
+			account(scheduler, source->class, length, queued_us);
+		}
+		streaming_mutex_unlock(&scheduler->mutex);
+		streaming_wakeup_signal(&scheduler->room);
+	}
+	return ret < 0 ? ret : (int)length;
+}
+
+static int send_from_queue(scheduler_t *scheduler, scheduler_source_t *source)
+{
+	streaming_mutex_lock(&scheduler->mutex);
+	bool pending = source->queue->num_packets > 0;
+	streaming_mutex_unlock(&scheduler->mutex);
+	if (!pending) {
+		return 0;
+	}
+
+	streaming_mutex_lock(&scheduler->send_mutex);
+	int ret = send_packet_locked(scheduler, source);
+	streaming_mutex_unlock(&scheduler->send_mutex);
+	return ret;
+}
+
+/**
+ * sends the packets queued in a class so far, send_mutex must be held. Packets queued meanwhile stay queued.
+ *
+ * @return <0 error of downstream
+ *         0  success
+ */
+static int send_queued_locked(scheduler_t *scheduler, scheduler_class_e class)
+{
+	// the queue sources come first, in the order of their class
+	scheduler_source_t *source = &scheduler->sources[class];
+
+	streaming_mutex_lock(&scheduler->mutex);
+	size_t pending = source->queue->complete;
+	streaming_mutex_unlock(&scheduler->mutex);
+	while (pending > 0) {
+		int ret = send_packet_locked(scheduler, source);
+		if (ret < 0) {
+			return ret;
+		}
+		// the last packet may have been completed after the bytes were counted
+		pending -= (size_t)ret < pending ? (size_t)ret : pending;
+	}
+	return 0;
+}
+
+static int send_from_ring(scheduler_t *scheduler, scheduler_source_t *source)
+{
+	const struct stream *downstream = scheduler->stream.downstream;
+
+	streaming_mutex_lock(&scheduler->send_mutex);
+	int length = streaming_sample_ring_drain(source->ring, scheduler->scratch, sizeof(scheduler->scratch));
+	if (length <= 0) {
+		streaming_mutex_unlock(&scheduler->send_mutex);
+		return length;
+	}
+	// meta information of the signal queued so far, e.g. for a new decimation, goes out before the samples
+	int ret = send_queued_locked(scheduler, source->class);
+	if (ret >= 0) {
+		ret = downstream->stream(downstream, (const char *)scheduler->scratch, length);
+	}
+	streaming_mutex_unlock(&scheduler->send_mutex);
+
+	streaming_mutex_lock(&scheduler->mutex);
+	account(scheduler, source->class, length, source->pending_us);
+	streaming_mutex_unlock(&scheduler->mutex);
+	// the remaining samples count as pending from now on
+	source->pending_us = 0;
+	return ret < 0 ? ret : length;
+}
+
+static int scheduler_send_packet(const struct stream *s, void *p)
+{
+	scheduler_t *scheduler = (scheduler_t *)s;
+	const struct stream *downstream = scheduler->stream.downstream;
+	int ret = 0;
+
+	// the packets queued before go out first, so a zero-copy packet does not overtake meta information
+	streaming_mutex_lock(&scheduler->send_mutex);
+	for (unsigned int class = 0; class < SCHEDULER_NUM_CLASSES && ret >= 0; class++) {
+		ret = send_queued_locked(scheduler, (scheduler_class_e)class);
+	}
+	if (ret < 0) {
+		downstream->pfree(downstream, p);
+	} else {
+		ret = downstream->streamp(downstream, p);
+	}
+	streaming_mutex_unlock(&scheduler->send_mutex);
+	return ret;
+}
+
+static int scheduler_backlog(const struct stream *s)
+{
+	const scheduler_t *scheduler = (const scheduler_t *)s;
+	size_t queued = 0;
+
+	for (unsigned int i = 0; i < SCHEDULER_NUM_CLASSES; i++) {
+		queued += scheduler->queues[i].used;
+	}
+	return stream_passthrough_backlog(s, queued);
+}
+
+void streaming_scheduler_init(scheduler_t *scheduler, const struct stream *downstream)
+{
+	memset(scheduler, 0, sizeof(*scheduler));
+	stream_passthrough_init(&scheduler->stream, &scheduler->lock, downstream, scheduler_send, scheduler_send_packet,
+	                        scheduler_backlog);
+	// the segments of one call are queued under one lock
+	scheduler->stream.streamv = scheduler_send_segments;
+
+	for (unsigned int i = 0; i < SCHEDULER_NUM_CLASSES; i++) {
+		scheduler_source_t *source = &scheduler->sources[scheduler->num_sources++];
+		source->queue = &scheduler->queues[i];
+		source->class = (scheduler_class_e)i;
+		source->weight = 1;
+	}
+	scheduler->running = true;
+	streaming_mutex_init(&scheduler->mutex);
+	streaming_mutex_init(&scheduler->send_mutex);
+	streaming_wakeup_init(&scheduler->wakeup);
+	streaming_wakeup_init(&scheduler->room);
+}
+
+int streaming_scheduler_add_ring(scheduler_t *scheduler, sample_ring_t *ring)
+{
+	signal_definition_t *def = ring->signal->definition;
+
+	if (scheduler->num_sources >= SCHEDULER_NUM_CLASSES + STREAMING_SCHEDULER_MAX_RINGS) {
+		return -1;
+	}
+
+	streaming_mutex_lock(&scheduler->mutex);
+	scheduler_source_t *source = &scheduler->sources[scheduler->num_sources];
+	memset(source, 0, sizeof(*source));
+	source->ring = ring;
+	source->class = def->priority == priority_high ? scheduler_class_high : scheduler_class_bulk;
+	source->weight = def->weight ? def->weight : 1;
+	scheduler->num_sources++;
+	streaming_mutex_unlock(&scheduler->mutex);
+	return 0;
+}
+
+static bool source_pending(scheduler_t *scheduler, scheduler_source_t *source)
+{
+	if (source->queue != NULL) {
+		streaming_mutex_lock(&scheduler->mutex);
+		bool pending = source->queue->num_packets > 0;
+		streaming_mutex_unlock(&scheduler->mutex);
+		return pending;
+	}
+
+	sample_ring_stats_t stats;
+	streaming_sample_ring_stats(source->ring, &stats);
+	if (stats.fill == 0) {
+		source->pending_us = 0;
+		return false;
+	}
+	if (source->pending_us == 0) {
+		source->pending_us = streaming_os_time_us();
+	}
+	return true;
+}
+
+/**
+ * deficit round robin over the sources of a class, one packet per call
+ */
+static int poll_class(scheduler_t *scheduler, scheduler_class_e class)
+{
+	unsigned int num = scheduler->num_sources;
+
+	for (unsigned int tries = 0; tries < 2 * num; tries++) {
+		unsigned int i = scheduler->next[class] % num;
+		scheduler_source_t *source = &scheduler->sources[i];
+
+		if (source->class != class) {
+			scheduler->next[class] = i + 1;
+			continue;
+		}
+		if (!source_pending(scheduler, source)) {
+			// an idle source does not save up
+			source->deficit = 0;
+		} else {
+			if (!source->visited) {
+				source->deficit += (int32_t)(source->weight * STREAMING_SCHEDULER_QUANTUM);
+				source->visited = true;
+			}
+			if (source->deficit > 0) {
+				int ret = source->queue != NULL ? send_from_queue(scheduler, source) : send_from_ring(scheduler, source);
+				if (ret > 0) {
+					source->deficit -= ret;
+				}
+				if (ret != 0) {
+					return ret;
+				}
+			}
+		}
+		source->visited = false;
+		scheduler->next[class] = i + 1;
+	}
+	return 0;
+}
+
+int streaming_scheduler_poll(scheduler_t *scheduler)
+{
+	for (unsigned int class = 0; class < SCHEDULER_NUM_CLASSES; class++) {
+		int ret = poll_class(scheduler, (scheduler_class_e)class);
+		if (ret != 0) {
+			// the queued bytes count as backlog until they are sent. The fill level is reported by the next
+			// writer, the flush task would wait for itself if it queued the report into a full control queue.
+			streaming_congestion_recalculate(&scheduler->stream);
+			return ret;
+		}
+	}
+	return 0;
+}
+
+void streaming_scheduler_run(scheduler_t *scheduler)
+{
+	while (scheduler->running) {
+		if (streaming_scheduler_poll(scheduler) <= 0) {
+			// sample rings are filled without waking the scheduler up
+			streaming_wakeup_wait(&scheduler->wakeup, STREAMING_SCHEDULER_IDLE_MS);
+		}
+	}
+}
+
+void streaming_scheduler_stop(scheduler_t *scheduler)
+{
+	scheduler->running = false;
+	streaming_wakeup_signal(&scheduler->wakeup);
+	streaming_wakeup_signal(&scheduler->room);
+}
+
+void streaming_scheduler_stats(scheduler_t *scheduler, scheduler_class_e class, scheduler_class_stats_t *stats)
+{
+	streaming_mutex_lock(&scheduler->mutex);
+	*stats = scheduler->stats[class];
+	streaming_mutex_unlock(&scheduler->mutex);
+}
@@ -0,0 +1,158 @@
+#ifndef _STREAMING_SCHEDULER_H_
+#define _STREAMING_SCHEDULER_H_
+
+#include "stream_id.h"
+#include "streaming_config.h"
+#include "streaming_os.h"
+#include "streaming_packet.h"
+#include "streaming_sample_ring.h"
+#include "streaming_signals.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * a transmit scheduler sits in front of a stream and decides the order in which packets go out. It is a stream
+ * itself: everything sent through scheduler->stream is split into packets and queued by class, meta information
+ * of the connection as control, data packets and the meta information of a signal by the priority of the signal,
+ * so the meta information stays in order with the samples. Sample rings added to the scheduler are drained one
+ * packet at a time, after the packets queued in their class.
+ *
+ * The flush task running streaming_scheduler_run sends one packet per step, always from the highest class with
+ * pending data: control first, then high priority, then bulk. Bulk sources share the bandwidth by weight (deficit
+ * round robin). Large blocks from sample rings are split into packets of at most STREAMING_SCHEDULER_PACKET_SIZE
+ * bytes, so a waveform block is preempted at the next packet boundary.
+ *
+ * Packets written through scheduler->stream are queued in parts of at most STREAMING_SCHEDULER_PACKET_SIZE bytes, so
+ * packets larger than a queue pass as well. The parts of a packet are sent back to back, so a large packet is not
+ * preempted: control and high priority traffic wait until all of it went out. Large blocks should go through a sample
+ * ring instead, which is drained in packets of at most STREAMING_SCHEDULER_PACKET_SIZE bytes. A writer waits while the
+ * queue of its packet is full. A data packet is rejected if its first part does not fit, meta information is never
+ * rejected, its writer waits for the flush task instead.
+ *
+ * Zero-copy packets are not queued. The packets queued so far are sent first, then the zero-copy packet, both by
+ * the writing task.
+ */
+
+typedef enum {
+	scheduler_class_control,
+	scheduler_class_high,
+	scheduler_class_bulk,
+	SCHEDULER_NUM_CLASSES,
+} scheduler_class_e;
+
+// a queued packet or a part of a large packet
+typedef struct {
+	size_t length;
+	// time the first byte of the part was queued
+	uint64_t queued_us;
+	// the part ends its packet, otherwise the packet continues in the next part
+	bool last;
+} scheduler_packet_t;
+
+// complete parts followed by at most one incomplete part
+typedef struct {
+	unsigned char data[STREAMING_SCHEDULER_QUEUE_SIZE];
+	size_t used;
+	// bytes at the start of data forming complete parts
+	size_t complete;
+	uint64_t partial_us;
+	scheduler_packet_t packets[STREAMING_SCHEDULER_QUEUE_PACKETS];
+	unsigned int num_packets;
+} scheduler_queue_t;
+
+// a queue or a sample ring the scheduler takes packets from
+typedef struct {
+	scheduler_queue_t *queue;
+	sample_ring_t *ring;
+	scheduler_class_e class;
+	uint32_t weight;
+	int32_t deficit;
+	bool visited;
+	// time the scheduler first found pending samples in the ring, 0 if none
+	uint64_t pending_us;
+} scheduler_source_t;
+
+typedef struct {
+	// packets sent
+	uint32_t packets;
+	uint64_t bytes;
+	// time from queuing to sending, for sample rings from the first time the scheduler found samples pending
+	uint64_t latency_sum_us;
+	uint32_t latency_max_us;
+	// data packets rejected because the queue was full
+	uint32_t rejected;
+} scheduler_class_stats_t;
+
+// the packet currently written through the scheduling stream. Writes may split packets anywhere, the class is
+// known once the headers are complete.
+typedef struct {
+	unsigned char header[STREAMING_HEADER_SIZE_MAX];
+	size_t header_used;
+	// class of the open packet, SCHEDULER_NUM_CLASSES if it was rejected
+	unsigned int class;
+	bool open;
+	size_t remaining;
+} scheduler_incoming_t;
+
+typedef struct {
+	// the scheduling stream, must be the first member
+	struct stream stream;
+	struct stream_lock lock;
+	scheduler_queue_t queues[SCHEDULER_NUM_CLASSES];
+	scheduler_incoming_t incoming;
+	scheduler_source_t sources[SCHEDULER_NUM_CLASSES + STREAMING_SCHEDULER_MAX_RINGS];
+	unsigned int num_sources;
+	// round robin position per class
+	unsigned int next[SCHEDULER_NUM_CLASSES];
+	scheduler_class_stats_t stats[SCHEDULER_NUM_CLASSES];
+	bool running;
+	// protects the queues and the statistics
+	streaming_mutex_t mutex;
+	// serializes the writes to downstream
+	streaming_mutex_t send_mutex;
+	streaming_wakeup_t wakeup;
+	// wakes up a writer waiting for room in a queue
+	streaming_wakeup_t room;
+	unsigned char scratch[STREAMING_SCHEDULER_PACKET_SIZE];
+} scheduler_t;
+
+/**
+ * sets up a transmit scheduler in front of downstream
+ *
+ * @param scheduler the scheduler to set up, must stay valid
+ * @param downstream the stream the packets are written to
+ */
+void streaming_scheduler_init(scheduler_t *scheduler, const struct stream *downstream);
+
+/**
+ * lets the scheduler drain a sample ring. The ring must belong to a signal subscribed through scheduler->stream.
+ *
+ * @return <0 error, too many rings
+ *         0  success
+ */
+int streaming_scheduler_add_ring(scheduler_t *scheduler, sample_ring_t *ring);
+
+/**
+ * sends one packet of the highest class with pending data. All parts of a large packet are sent, waiting for its
+ * writer to queue them.
+ *
+ * @return <0    error of downstream
+ *         0     nothing to send
+ *         else  number of bytes sent
+ */
+int streaming_scheduler_poll(scheduler_t *scheduler);
+
+/**
+ * body of the transmit task, sends packets until streaming_scheduler_stop
+ */
+void streaming_scheduler_run(scheduler_t *scheduler);
+
+void streaming_scheduler_stop(scheduler_t *scheduler);
+
+/**
+ * copies the statistics of a class
+ */
+void streaming_scheduler_stats(scheduler_t *scheduler, scheduler_class_e class, scheduler_class_stats_t *stats);
+
+#endif
@@ -17,7 +17,13 @@
 #include "streaming_signals.h"
 #include "RTOS.h"
 #include "streaming_config.h"
+#include "streaming_decimation.h"
+#include "streaming_encoding.h"
 #include "streaming_handler.h"
+#include "streaming_meta.h"
+#include "streaming_quantization.h"
+#include "streaming_struct.h"
+#include <string.h>
 
 static OS_MUTEX signal_mutex;
 static uint32_t signal_counter = 0;
@@ -54,6 +60,7 @@ static signal_t *signals_add_signal(signal_definition_t *def, signal_table_t *ta
 	OS_MUTEX_LockBlocked(&signal_mutex);
 	// check if we can handle more signals
 	if (signal_counter >= STREAMING_MAX_SIGNALS) {
+		OS_MUTEX_Unlock(&signal_mutex);
 		return NULL;
 	}
 
@@ -62,15 +69,81 @@ static signal_t *signals_add_signal(signal_definition_t *def, signal_table_t *ta
 	signal->available = !def->hidden;
 	signal->definition = def;
 	signal->table = table;
+	signal->last_valid = false;
+	decimation_init(&signal->decimation, decimation_none, 0);
+	signal->encoding = encoding_none;
+	signal->congestion_decimated = false;
+	signal->sample_index = 0;
+	signal->gap = 0;
 	OS_MUTEX_Unlock(&signal_mutex);
 	return signal;
 }
 
+/**
+ * struct signals are serialized by their struct object, an invalid one would have records without size
+ */
+static bool signal_definition_valid(const signal_definition_t *def)
+{
+	return def->datatype != signal_type_struct || struct_valid(def);
+}
+
+static bool subscribe_options_valid(signal_definition_t *def, const subscribe_options_t *options)
+{
+	if (options->decimation == decimation_none && options->encoding == encoding_none) {
+		return true;
+	}
+	if (def->rule != signal_explicit_rule) {
+		// only explicit signals can be decimated or encoded
+		return false;
+	}
+	if (options->decimation != decimation_none) {
+		// decimated samples are always sent raw and unquantized
+		return options->encoding == encoding_none && decimation_supported(def->datatype) &&
+		       !quantization_active(def) && decimation_valid(options->decimation, options->factor);
+	}
+	return (def->encodings & ENCODING_MASK(options->encoding)) && encoding_supported(def->datatype);
+}
+
+/**
+ * whether the meta information of the signal fits into MSGPACK_BUF_SIZE with every subscription option allowed for
+ * it, the largest value index and the largest domain factor of its table
+ */
+static bool signal_meta_fits(signal_t *signal)
+{
+	static const subscribe_options_t options[] = {
+	    {.decimation = decimation_none, .encoding = encoding_none},
+	    {.decimation = decimation_minmax, .factor = UINT32_MAX - 1, .encoding = encoding_none},
+	    {.decimation = decimation_none, .encoding = encoding_delta_varint},
+	    {.decimation = decimation_none, .encoding = encoding_frame_of_reference},
+	};
+	char mpack_buff[MSGPACK_BUF_SIZE];
+	bool fits = true;
+
+	signal->table->domain_factor = UINT32_MAX;
+	for (unsigned int i = 0; i < sizeof(options) / sizeof(options[0]) && fits; i++) {
+		if (!subscribe_options_valid(signal->definition, &options[i])) {
+			continue;
+		}
+		decimation_init(&signal->decimation, options[i].decimation, options[i].factor);
+		signal->encoding = options[i].encoding;
+		fits = build_mpack_meta_signal(mpack_buff, sizeof(mpack_buff), signal, UINT64_MAX) >= 0;
+	}
+	signal->table->domain_factor = 1;
+	decimation_init(&signal->decimation, decimation_none, 0);
+	signal->encoding = encoding_none;
+	return fits;
+}
+
 signal_table_t *signals_add_table(signal_definition_t *def, unsigned int count, const char *table_name)
 {
 	if (count == 0) {
 		return NULL;
 	}
+	for (unsigned int i = 0; i < count; i++) {
+		if (!signal_definition_valid(&def[i])) {
+			return NULL;
+		}
+	}
 
 	OS_MUTEX_LockBlocked(&signal_mutex);
 
@@ -86,8 +159,20 @@ signal_table_t *signals_add_table(signal_definition_t *def, unsigned int count,
 	}
 	table->signal_counter = count;
 	table->subscribed_value_signal_count = 0;
+	table->domain_factor = 1;
+	table->dropped = 0;
 	table->tableId = table_name;
 
+	for (unsigned int i = 0; i < count; i++) {
+		if (!signal_meta_fits(&table->signals[i])) {
+			// the meta information of the signal could never be sent, the table is taken back
+			signal_counter -= count;
+			table_counter--;
+			OS_MUTEX_Unlock(&signal_mutex);
+			return NULL;
+		}
+	}
+
 	OS_MUTEX_Unlock(&signal_mutex);
 	return table;
 }
@@ -97,6 +182,30 @@ bool signal_has_subscription(signal_t *signal)
 	return signal->stream != NULL;
 }
 
+/**
+ * all value signals of a table share the domain, so their decimations must agree on the domain factor
+ */
+static uint32_t table_domain_factor(const signal_table_t *table)
+{
+	for (unsigned int i = 0; i < table->signal_counter; i++) {
+		if (decimation_active(&table->signals[i].decimation)) {
+			return decimation_domain_factor(&table->signals[i].decimation);
+		}
+	}
+	return 1;
+}
+
+void signal_table_domain_changed(signal_table_t *table)
+{
+	table->domain_factor = table_domain_factor(table);
+	for (unsigned int i = 0; i < table->signal_counter; i++) {
+		signal_t *signal = &table->signals[i];
+		if (signal->definition->rule == signal_linear_rule && signal_has_subscription(signal)) {
+			streaming_send_meta_signal(signal->stream, signal, 0);
+		}
+	}
+}
+
 static int _signal_subscribe(const struct stream *stream, signal_t *signal, uint64_t valueIndex)
 {
 	if (signal->stream != NULL) {
@@ -105,6 +214,10 @@ static int _signal_subscribe(const struct stream *stream, signal_t *signal, uint
 
 	signal->stream = stream;
 	signal->subscribed = true;
+	// force the next constant sample out, so the new subscriber gets an initial value
+	signal->last_valid = false;
+	signal->sample_index = valueIndex;
+	signal->gap = 0;
 	streaming_send_subscribed(stream, signal);
 	streaming_send_meta_signal(stream, signal, valueIndex);
 	return 0;
@@ -118,22 +231,65 @@ static int _signal_unsubscribe(const struct stream *stream, signal_t *signal)
 
 	signal->subscribed = false;
 	signal->stream = NULL;
+	decimation_init(&signal->decimation, decimation_none, 0);
+	signal->encoding = encoding_none;
+	signal->congestion_decimated = false;
 	streaming_send_unsubscribed(stream, signal);
 	return 0;
 }
 
 int signals_subscribe(const struct stream *stream, const char *signalId)
+{
+	return signals_subscribe_decimated(stream, signalId, decimation_none, 0);
+}
+
+int signals_subscribe_decimated(const struct stream *stream, const char *signalId, decimation_mode_e mode,
+                                uint32_t factor)
+{
+	subscribe_options_t options = {
+	    .decimation = mode,
+	    .factor = factor,
+	    .encoding = encoding_none,
+	};
+	return signals_subscribe_with_options(stream, signalId, &options);
+}
+
+int signals_subscribe_with_options(const struct stream *stream, const char *signalId,
+                                   const subscribe_options_t *options)
 {
 	OS_MUTEX_LockBlocked(&signal_mutex);
 	signal_t *signal = get_signal_by_id(signalId);
 
-	if (signal == NULL) {
+	if (signal == NULL || !subscribe_options_valid(signal->definition, options)) {
 		OS_MUTEX_Unlock(&signal_mutex);
 		return -1;
 	}
 
 	signal_table_t *table = signal->table;
 
+	if (signal->stream == NULL) {
+		decimation_t decimation;
+		decimation_init(&decimation, options->decimation, options->factor);
+		if (table != NULL && table->subscribed_value_signal_count > 0 &&
+		    decimation_domain_factor(&decimation) != table->domain_factor) {
+			// the other value signals of the table are sent at a different rate
+			OS_MUTEX_Unlock(&signal_mutex);
+			return -1;
+		}
+		// decimation and encoding are part of the subscription, an existing subscription keeps them
+		signal->decimation = decimation;
+		signal->encoding = options->encoding;
+		signal->congestion_decimated = false;
+		if (table != NULL) {
+			// the related signals below are announced with the scaled domain
+			table->domain_factor = table_domain_factor(table);
+			if (table->subscribed_value_signal_count == 0) {
+				// a new client counts from the value index on
+				table->dropped = 0;
+			}
+		}
+	}
+
 	if (table != NULL) {
 		signal_t *related_signal = table->signals;
 		for (unsigned int i = 0; i < table->signal_counter; i++) {
@@ -153,7 +309,7 @@ int signals_subscribe(const struct stream *stream, const char *signalId)
 			streaming_cbs->on_subscribe(stream, &related_signal[i]);
 			_signal_subscribe(stream, &related_signal[i], 0); // valueIndex is fixed to 0 and gets ignored
 		}
-		if (!signal->subscribed && signal->definition.signaltype == signal_type_value) {
+		if (!signal->subscribed && signal->definition->signaltype == signal_type_value) {
 			table->subscribed_value_signal_count++;
 		}
 	}
@@ -207,6 +363,9 @@ int signals_unsubscribe(const struct stream *stream, const char *signalId)
 
 	int ret = _signal_unsubscribe(stream, signal);
 	streaming_cbs->on_unsubscribe(stream, signal);
+	if (table != NULL) {
+		table->domain_factor = table_domain_factor(table);
+	}
 	OS_MUTEX_Unlock(&signal_mutex);
 	return ret;
 }
@@ -217,8 +376,13 @@ void signals_purge_stream(const struct stream *stream)
 		if (signals[i].stream == stream) {
 			signals[i].stream = NULL;
 			signals[i].subscribed = false;
+			decimation_init(&signals[i].decimation, decimation_none, 0);
+			signals[i].encoding = encoding_none;
+			signals[i].congestion_decimated = false;
 			if (signals[i].table != NULL) {
 				signals[i].table->subscribed_value_signal_count = 0;
+				signals[i].table->domain_factor = 1;
+				signals[i].table->dropped = 0;
 			}
 		}
 	}
@@ -228,4 +392,12 @@ unsigned int signal_get_signal_no(signal_t *signal)
 {
 	// use index + 1  as signal_number, since signal_number cannot be 0
 	return (signal - signals) + 1;
-}
\ No newline at end of file
+}
+
+signal_t *signal_get_by_signal_no(unsigned int signal_no)
+{
+	if (signal_no == 0 || signal_no > signal_counter) {
+		return NULL;
+	}
+	return &signals[signal_no - 1];
+}
@@ -49,8 +49,73 @@ typedef enum {
 	signal_type_real64,
 	signal_type_complex32,
 	signal_type_complex64,
+	// packed flags, the number gives the width of the word in bits
+	signal_type_bitfield8,
+	signal_type_bitfield16,
+	signal_type_bitfield32,
+	signal_type_bitfield64,
+	// records of several fields, described by a struct object
+	signal_type_struct,
 } signal_data_type_e;
 
+typedef struct {
+	const char *name;
+	signal_data_type_e datatype;
+	// offset in bytes of the field inside the record at the source
+	size_t offset;
+} struct_field_t;
+
+typedef struct {
+	// size in bytes of one record at the source, usually sizeof() of the acquisition struct
+	size_t record_size;
+	uint8_t num_fields;
+	struct_field_t fields[];
+} struct_object_t;
+
+static inline bool signal_data_type_is_bitfield(signal_data_type_e datatype)
+{
+	return datatype >= signal_type_bitfield8 && datatype <= signal_type_bitfield64;
+}
+
+typedef struct {
+	uint8_t num_bits;
+	// name of each bit, starting with the least significant bit. Bits without a name (NULL) are not advertised.
+	const char *bits[];
+} bitfield_object_t;
+
+typedef struct {
+	// integer type transmitted instead of the real values, int16 or int32
+	signal_data_type_e datatype;
+} quantization_object_t;
+
+typedef struct {
+	// number of source samples per spectrum, a power of 2. A spectrum has size / 2 + 1 bins.
+	uint32_t size;
+	// sample rate of the source in Hz, the bins are sampleRate / size apart
+	double sampleRate;
+	// number of consecutive blocks whose power is averaged into one spectrum, 0 and 1 average nothing
+	uint32_t averages;
+} spectrum_object_t;
+
+// transmit priority of a signal, see streaming_scheduler.h
+typedef enum {
+	// waveforms and other large blocks, scheduled fairly by weight
+	priority_bulk,
+	// status and time signals, sent before all bulk signals
+	priority_high,
+} priority_class_e;
+
+// what happens to the samples of an explicit signal while its stream is congested
+typedef enum {
+	// send anyway, the sender blocks until the network takes the data
+	congestion_block,
+	// discard samples, a direct send discards its block, a sample ring the samples that do not fit into one packet
+	// with the newest ones. The client is told about every gap, see openDAQ_streaming_send_gap.
+	congestion_discard,
+	// send min/max decimated samples until the congestion clears
+	congestion_decimate,
+} congestion_policy_e;
+
 typedef struct {
 	const char *name;
 	signal_rule_e rule;
@@ -61,8 +126,67 @@ typedef struct {
 	const time_object_t *time;
 	const range_object_t *range;
 	const postScaling_object_t *postScaling;
+	// constant rule only: unchanged values are sent again after keyframe indices, 0 disables keyframes
+	uint64_t keyframe;
+	// linear rule only: allowed deviation of an observed value from start + n * delta before a resync
+	uint64_t tolerance;
+	// explicit rule only: payload encodings a client may request, ENCODING_MASK of encoding_mode_e, 0 for raw only
+	uint32_t encodings;
+	// explicit real rule only: transmit the samples as integers scaled to range, optional
+	const quantization_object_t *quantization;
+	// bitfield datatypes only: names of the bits
+	const bitfield_object_t *bitfield;
+	// struct datatype only: fields of the records
+	const struct_object_t *structure;
+	// spectrum signals only: bins of the spectrum derived from an explicit signal, see streaming_spectrum.h
+	const spectrum_object_t *spectrum;
+	// explicit rule only: behaviour while the stream is congested
+	congestion_policy_e congestion;
+	// congestion_decimate only: decimation factor, 0 for STREAMING_CONGESTION_DECIMATION
+	uint32_t congestion_factor;
+	// transmit priority, bulk by default
+	priority_class_e priority;
+	// bulk signals only: share of the bandwidth relative to other bulk signals, 0 counts as 1
+	uint8_t weight;
 } signal_definition_t;
 
+typedef enum {
+	encoding_none,
+	encoding_delta_varint,
+	encoding_frame_of_reference,
+} encoding_mode_e;
+
+#define ENCODING_MASK(mode) (1u << (mode))
+
+typedef enum {
+	decimation_none,
+	decimation_minmax,
+	decimation_mean,
+} decimation_mode_e;
+
+// per subscription reduction of explicit signals, see streaming_decimation.h
+typedef union {
+	int64_t i;
+	uint64_t u;
+	double d;
+} decimation_value_t;
+
+typedef struct {
+	decimation_mode_e mode;
+	uint32_t factor;
+	uint32_t count;
+	decimation_value_t min;
+	decimation_value_t max;
+	double sum;
+} decimation_t;
+
+// options a client passes along with a subscription
+typedef struct {
+	decimation_mode_e decimation;
+	uint32_t factor;
+	encoding_mode_e encoding;
+} subscribe_options_t;
+
 typedef struct signal_table_t signal_table_t;
 
 typedef struct signal_t {
@@ -71,6 +195,19 @@ typedef struct signal_t {
 	struct signal_table_t *table;
 	signal_definition_t *definition;
 	bool subscribed;
+	// last transmitted sample of a constant or linear rule signal, invalidated on subscribe
+	bool last_valid;
+	uint64_t last_index;
+	uint64_t last_value[2];
+	decimation_t decimation;
+	// payload encoding of explicit signals, negotiated on subscribe
+	encoding_mode_e encoding;
+	// decimation switched on by the congestion policy, not by the client
+	bool congestion_decimated;
+	// explicit rule only: index of the next sample, counts the transmitted and the dropped samples
+	uint64_t sample_index;
+	// explicit rule only: samples a direct send discarded, signalled in front of the next samples sent
+	uint32_t gap;
 } signal_t;
 
 struct signal_table_t {
@@ -78,16 +215,45 @@ struct signal_table_t {
 	const char *tableId;
 	struct signal_t *signals;
 	unsigned int subscribed_value_signal_count;
+	// input samples per transmitted sample of the decimated value signals, scales the indices and linear deltas
+	uint32_t domain_factor;
+	// value samples dropped since the first value signal was subscribed, the client never counted them
+	uint64_t dropped;
 };
 
+/**
+ * index of a sample on the wire. Dropped samples were never transmitted and decimated value signals count
+ * transmitted samples, so all indices of a table are shifted by the dropped samples and scaled down by the
+ * domain factor.
+ */
+static inline uint64_t signal_wire_index(const signal_t *signal, uint64_t index)
+{
+	const signal_table_t *table = signal->table;
+
+	if (table == NULL) {
+		return index;
+	}
+	index -= table->dropped;
+	return table->domain_factor > 1 ? index / table->domain_factor : index;
+}
+
 void signals_init(void);
 void signals_send_all_avail(const struct stream *stream);
 int signals_subscribe(const struct stream *stream, const char *signalId);
+int signals_subscribe_decimated(const struct stream *stream, const char *signalId, decimation_mode_e mode,
+                                uint32_t factor);
+int signals_subscribe_with_options(const struct stream *stream, const char *signalId,
+                                   const subscribe_options_t *options);
 int signals_unsubscribe(const struct stream *stream, const char *signalId);
-signal_t *signals_add_signal(signal_definition_t *def, signal_table_t *table);
 signal_table_t *signals_add_table(signal_definition_t *def, unsigned int count, const char *table_name);
 bool signal_has_subscription(signal_t *signal);
 unsigned int signal_get_signal_no(signal_t *signal);
+signal_t *signal_get_by_signal_no(unsigned int signal_no);
 void signals_purge_stream(const struct stream *stream);
+/**
+ * takes over a changed decimation of a value signal of the table, the subscribed linear signals get new meta
+ * information with the scaled delta
+ */
+void signal_table_domain_changed(signal_table_t *table);
 
 #endif
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "streaming_spectrum.h"
+#include "streaming_endian.h"
+#include "streaming_packet.h"
+#include <math.h>
+
+// source samples are converted and windowed in chunks of this size
+#define SPECTRUM_CHUNK_SIZE 64
+
+#define SPECTRUM_PI 3.14159265358979323846
+
+bool spectrum_supported(signal_data_type_e datatype)
+{
+	switch (datatype) {
+	case signal_type_int8:
+	case signal_type_uint8:
+	case signal_type_int16:
+	case signal_type_uint16:
+	case signal_type_int32:
+	case signal_type_uint32:
+	case signal_type_int64:
+	case signal_type_uint64:
+	case signal_type_real32:
+	case signal_type_real64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * @return the linear frequency domain in the table of the spectrum signal, NULL if there is none
+ */
+static signal_t *spectrum_domain(signal_t *signal)
+{
+	signal_table_t *table = signal->table;
+
+	if (table == NULL) {
+		return NULL;
+	}
+	for (unsigned int i = 0; i < table->signal_counter; i++) {
+		signal_definition_t *def = table->signals[i].definition;
+		if (def->signaltype == signal_type_time && def->rule == signal_linear_rule &&
+		    def->datatype == signal_type_real64) {
+			return &table->signals[i];
+		}
+	}
+	return NULL;
+}
+
+int streaming_spectrum_add(spectrum_t *spectrum, signal_t *signal, signal_data_type_e source_datatype, void *work,
+                           size_t work_size)
+{
+	signal_definition_t *def = signal->definition;
+	const spectrum_object_t *obj = def->spectrum;
+
+	if (def->rule != signal_explicit_rule || def->datatype != signal_type_real32 || obj == NULL) {
+		return -1;
+	}
+	if (obj->size < 4 || (obj->size & (obj->size - 1)) != 0 || !spectrum_supported(source_datatype)) {
+		return -1;
+	}
+	if (work_size < SPECTRUM_WORK_SIZE(obj->size) || spectrum_domain(signal) == NULL) {
+		return -1;
+	}
+
+	uint32_t size = obj->size;
+	double window_sum = 0;
+
+	spectrum->signal = signal;
+	spectrum->domain = spectrum_domain(signal);
+	spectrum->index = 0;
+	spectrum->source_datatype = source_datatype;
+	spectrum->size = size;
+	spectrum->averages = obj->averages > 1 ? obj->averages : 1;
+	spectrum->window = work;
+	spectrum->twiddle = spectrum->window + size;
+	spectrum->block = spectrum->twiddle + size;
+	spectrum->power = spectrum->block + size;
+	spectrum->fill = 0;
+	spectrum->count = 0;
+
+	// periodic Hann window
+	for (uint32_t i = 0; i < size; i++) {
+		double w = 0.5 - 0.5 * cos(2 * SPECTRUM_PI * i / size);
+		spectrum->window[i] = (float)w;
+		window_sum += w;
+	}
+	// single sided amplitude spectrum, corrected for the coherent gain of the window
+	spectrum->scale = (float)(2 / window_sum);
+
+	for (uint32_t k = 0; k < size / 2; k++) {
+		spectrum->twiddle[2 * k] = (float)cos(2 * SPECTRUM_PI * k / size);
+		spectrum->twiddle[2 * k + 1] = (float)-sin(2 * SPECTRUM_PI * k / size);
+	}
+	return 0;
+}
+
+void spectrum_fft(float *data, uint32_t n, const float *twiddle, uint32_t stride)
+{
+	// bit reversed order
+	for (uint32_t i = 1, j = 0; i < n; i++) {
+		uint32_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) {
+			float re = data[2 * i];
+			float im = data[2 * i + 1];
+			data[2 * i] = data[2 * j];
+			data[2 * i + 1] = data[2 * j + 1];
+			data[2 * j] = re;
+			data[2 * j + 1] = im;
+		}
+	}
+
+	// first stage, all twiddle factors are 1
+	for (uint32_t i = 0; i + 1 < n; i += 2) {
+		float *a = data + 2 * i;
+		float re = a[2];
+		float im = a[3];
+		a[2] = a[0] - re;
+		a[3] = a[1] - im;
+		a[0] += re;
+		a[1] += im;
+	}
+
+	for (uint32_t len = 4; len <= n; len <<= 1) {
+		uint32_t half = len >> 1;
+		uint32_t step = stride * (n / len);
+
+		// every twiddle factor is loaded once per stage
+		for (uint32_t j = 0; j < half; j++) {
+			float wr = twiddle[2 * j * step];
+			float wi = twiddle[2 * j * step + 1];
+
+			for (uint32_t i = j; i < n; i += len) {
+				float *a = data + 2 * i;
+				float *b = data + 2 * (i + half);
+				float re = b[0] * wr - b[1] * wi;
+				float im = b[0] * wi + b[1] * wr;
+				b[0] = a[0] - re;
+				b[1] = a[1] - im;
+				a[0] += re;
+				a[1] += im;
+			}
+		}
+	}
+}
+
+/**
+ * transforms the windowed block and adds the power of its bins. The real block of size samples is transformed
+ * as size / 2 complex values, even samples as real and odd samples as imaginary part, and split into the
+ * spectrum of the real signal afterwards.
+ */
+static void spectrum_accumulate(spectrum_t *spectrum)
+{
+	uint32_t m = spectrum->size / 2;
+	const float *z = spectrum->block;
+	const float *w = spectrum->twiddle;
+	float *power = spectrum->power;
+	bool first = spectrum->count == 0;
+
+	spectrum_fft(spectrum->block, m, w, 2);
+
+	float dc = z[0] + z[1];
+	float nyquist = z[0] - z[1];
+	power[0] = (first ? 0 : power[0]) + dc * dc;
+	power[m] = (first ? 0 : power[m]) + nyquist * nyquist;
+
+	for (uint32_t k = 1; k < m; k++) {
+		float a = z[2 * k];
+		float b = z[2 * k + 1];
+		float c = z[2 * (m - k)];
+		float d = z[2 * (m - k) + 1];
+		// X[k] = E + w^k O with E = (Z[k] + conj(Z[m - k])) / 2, O = -i (Z[k] - conj(Z[m - k])) / 2
+		float e_re = 0.5f * (a + c);
+		float e_im = 0.5f * (b - d);
+		float o_re = 0.5f * (b + d);
+		float o_im = -0.5f * (a - c);
+		float xr = e_re + w[2 * k] * o_re - w[2 * k + 1] * o_im;
+		float xi = e_im + w[2 * k] * o_im + w[2 * k + 1] * o_re;
+		power[k] = (first ? 0 : power[k]) + xr * xr + xi * xi;
+	}
+}
+
+/**
+ * serializes the averaged amplitude of all bins, the block is reused to hold them. The domain starts again
+ * at 0 Hz with the first bin.
+ */
+static int serialize_spectrum(spectrum_t *spectrum, unsigned char *dst, size_t dst_size)
+{
+	uint32_t bins = spectrum->size / 2 + 1;
+	float *amplitude = spectrum->block;
+	float scale = spectrum->scale;
+	float averages = (float)spectrum->averages;
+
+	for (uint32_t k = 0; k < bins; k++) {
+		amplitude[k] = sqrtf(spectrum->power[k] / averages) * scale;
+	}
+	// 0 Hz and the Nyquist frequency have no negative frequency counterpart
+	amplitude[0] *= 0.5f;
+	amplitude[bins - 1] *= 0.5f;
+
+	size_t len = 0;
+	if (signal_has_subscription(spectrum->domain)) {
+		double start = 0;
+		int ret = openDAQ_streaming_serialize_linear_signal(dst, dst_size, spectrum->index, spectrum->domain, &start);
+		if (ret < 0) {
+			return ret;
+		}
+		len = ret;
+	}
+
+	int ret = openDAQ_streaming_serialize_explicit_signal(dst + len, dst_size - len, spectrum->signal, amplitude,
+	                                                      bins);
+	if (ret < 0) {
+		return ret;
+	}
+	spectrum->index += bins;
+	return len + ret;
+}
+
+int streaming_spectrum_process(spectrum_t *spectrum, void *dst, size_t dst_size, const void *src, unsigned int num)
+{
+	size_t sample_size = openDAQ_get_sample_size(spectrum->source_datatype);
+	const unsigned char *src_ptr = src;
+	unsigned char *dst_ptr = dst;
+	double chunk[SPECTRUM_CHUNK_SIZE];
+
+	if (!signal_has_subscription(spectrum->signal)) {
+		// the next subscription starts with a complete block and counts the bins from 0
+		spectrum->fill = 0;
+		spectrum->count = 0;
+		spectrum->index = 0;
+		return 0;
+	}
+
+	for (unsigned int done = 0; done < num;) {
+		uint32_t n = spectrum->size - spectrum->fill;
+		if (n > num - done) {
+			n = num - done;
+		}
+		if (n > SPECTRUM_CHUNK_SIZE) {
+			n = SPECTRUM_CHUNK_SIZE;
+		}
+
+		streaming_samples_to_double(spectrum->source_datatype, chunk, src_ptr + done * sample_size, n);
+		float *block = spectrum->block + spectrum->fill;
+		const float *window = spectrum->window + spectrum->fill;
+		for (uint32_t i = 0; i < n; i++) {
+			block[i] = (float)chunk[i] * window[i];
+		}
+		spectrum->fill += n;
+		done += n;
+
+		if (spectrum->fill < spectrum->size) {
+			continue;
+		}
+		spectrum->fill = 0;
+		spectrum_accumulate(spectrum);
+		if (++spectrum->count < spectrum->averages) {
+			continue;
+		}
+		spectrum->count = 0;
+
+		int ret = serialize_spectrum(spectrum, dst_ptr, dst_size - (dst_ptr - (unsigned char *)dst));
+		if (ret < 0) {
+			// the spectra written before are complete, the caller cannot undo them
+			size_t len = dst_ptr - (unsigned char *)dst;
+			return len == 0 ? ret : (int)len;
+		}
+		dst_ptr += ret;
+	}
+	return dst_ptr - (unsigned char *)dst;
+}
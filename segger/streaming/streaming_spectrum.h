@@ -0,0 +1,97 @@
+#ifndef _STREAMING_SPECTRUM_H_
+#define _STREAMING_SPECTRUM_H_
+
+#include "streaming_signals.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * a spectrum signal is derived from an explicit source signal. Blocks of spectrum->size source samples are
+ * weighted with a Hann window and transformed with a real FFT, the power of averages consecutive blocks is
+ * averaged. Each spectrum is sent as size / 2 + 1 real32 samples of the spectrum signal, holding the amplitude
+ * of the bins from 0 Hz up to half the sample rate. A sine of amplitude A shows as A in its bin.
+ *
+ * The spectrum signal is an explicit real32 value signal of a table of its own, its definition carries the
+ * spectrum_object_t. The domain of the table is a linear real64 signal of signal_type_time, which is advertised
+ * as frequency in Hz with the resolution as delta. Every spectrum starts with a domain packet holding 0 Hz at
+ * the index of its first bin, the indices of the bins count on from 0 at the subscription. Nothing is computed
+ * while the spectrum signal has no subscription.
+ */
+
+typedef struct {
+	// derived spectrum signal
+	signal_t *signal;
+	// frequency domain of the table of the spectrum signal
+	signal_t *domain;
+	// index of the first bin of the next spectrum
+	uint64_t index;
+	signal_data_type_e source_datatype;
+	uint32_t size;
+	uint32_t averages;
+	float scale;
+	// working memory, see SPECTRUM_WORK_SIZE
+	float *window;
+	// w^k = exp(-2 pi i k / size) for k < size / 2, interleaved real and imaginary part
+	float *twiddle;
+	// windowed samples of the current block, transformed in place
+	float *block;
+	// power of the bins summed over the averaged blocks
+	float *power;
+	uint32_t fill;
+	uint32_t count;
+} spectrum_t;
+
+// size in bytes of the working memory of a spectrum of size source samples
+#define SPECTRUM_WORK_SIZE(size) ((3 * (size) + (size) / 2 + 1) * sizeof(float))
+
+/**
+ * whether source signals of datatype can be transformed. Only integer types of up to 64 bit and real types
+ * are supported.
+ */
+bool spectrum_supported(signal_data_type_e datatype);
+
+/**
+ * sets up the spectrum of an explicit source signal and precomputes window and twiddle factors
+ *
+ * @param spectrum the spectrum to set up, must stay valid
+ * @param signal the spectrum signal, explicit real32 with a spectrum_object_t of at least 4 samples, in a table
+ *               with a linear real64 domain signal
+ * @param source_datatype datatype of the source samples passed to streaming_spectrum_process
+ * @param work working memory, aligned for float
+ * @param work_size size in bytes of work, at least SPECTRUM_WORK_SIZE(size)
+ *
+ * @return <0 error, e.g. invalid definition or work too small
+ *         0  success
+ */
+int streaming_spectrum_add(spectrum_t *spectrum, signal_t *signal, signal_data_type_e source_datatype, void *work,
+                           size_t work_size);
+
+/**
+ * feeds samples of the source signal through the spectrum and serializes every completed spectrum
+ *
+ * @param spectrum the spectrum
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ * @param src contiguous samples of the source signal
+ * @param num number of samples at src
+ *
+ * @return <0    error, destination buffer too small for the first completed spectrum, nothing was written. The
+ *               samples up to that spectrum were processed, the spectrum is dropped.
+ *         0     no spectrum completed or no subscription, nothing written
+ *         else  number of bytes written. If a later spectrum did not fit, the spectra written before are complete,
+ *               the failing spectrum is dropped and the samples after it are not processed.
+ */
+int streaming_spectrum_process(spectrum_t *spectrum, void *dst, size_t dst_size, const void *src, unsigned int num);
+
+/**
+ * in place radix-2 FFT of n complex values, interleaved real and imaginary part
+ *
+ * @param data n complex values
+ * @param n number of complex values, a power of 2
+ * @param twiddle w^k = exp(-2 pi i k / (stride * n)) for k < stride * n / 2, interleaved
+ * @param stride distance of the twiddle factors used for n
+ */
+void spectrum_fft(float *data, uint32_t n, const float *twiddle, uint32_t stride);
+
+#endif
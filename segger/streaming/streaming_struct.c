@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "streaming_struct.h"
+#include "streaming_endian.h"
+
+#define STRUCT_BLOCK_SIZE 64
+
+bool struct_valid(const signal_definition_t *def)
+{
+	const struct_object_t *structure = def->structure;
+
+	if (def->datatype != signal_type_struct || def->rule != signal_explicit_rule || structure == NULL) {
+		return false;
+	}
+	if (structure->num_fields == 0 || structure->record_size == 0) {
+		// records without fields have no size on the wire
+		return false;
+	}
+	for (unsigned int i = 0; i < structure->num_fields; i++) {
+		const struct_field_t *field = &structure->fields[i];
+		size_t field_size = openDAQ_get_sample_size(field->datatype);
+		// the name of every field is advertised in the signal meta information
+		if (field->name == NULL || field_size == 0 || field->offset + field_size > structure->record_size) {
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t struct_wire_size(const struct_object_t *structure)
+{
+	size_t size = 0;
+	for (unsigned int i = 0; i < structure->num_fields; i++) {
+		size += openDAQ_get_sample_size(structure->fields[i].datatype);
+	}
+	return size;
+}
+
+void struct_copy_records(const struct_object_t *structure, unsigned char *dst, const void *src, size_t stride,
+                         size_t num)
+{
+	size_t wire_size = struct_wire_size(structure);
+	const unsigned char *src_ptr = src;
+
+	// records are copied in blocks, so the source records stay in the cache while their fields are copied
+	while (num > 0) {
+		size_t n = num < STRUCT_BLOCK_SIZE ? num : STRUCT_BLOCK_SIZE;
+		unsigned char *field_dst = dst;
+
+		for (unsigned int i = 0; i < structure->num_fields; i++) {
+			const struct_field_t *field = &structure->fields[i];
+			streaming_copy_samples_le_strided(field->datatype, field_dst, wire_size, src_ptr + field->offset, stride,
+			                                  n);
+			field_dst += openDAQ_get_sample_size(field->datatype);
+		}
+
+		src_ptr += n * stride;
+		dst += n * wire_size;
+		num -= n;
+	}
+}
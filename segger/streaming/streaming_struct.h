@@ -0,0 +1,33 @@
+#ifndef _STREAMING_STRUCT_H_
+#define _STREAMING_STRUCT_H_
+
+#include "streaming_signals.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * explicit signals of datatype struct carry records, e.g. one row of a table sampled synchronously.
+ * On the wire the fields of a record follow each other without padding, in the order of the struct object,
+ * each in little endian byte order. Fields of datatype struct are not supported.
+ */
+
+/**
+ * whether the struct object of the definition can be serialized. Records need at least one field, and all
+ * fields must be named, of a known datatype and lie inside the record. Whether the field list fits into the
+ * signal meta information is checked by signals_add_table, which knows the other signals of the table.
+ */
+bool struct_valid(const signal_definition_t *def);
+
+/**
+ * size in bytes of one record on the wire
+ */
+size_t struct_wire_size(const struct_object_t *structure);
+
+/**
+ * copies num records at src, which are stride bytes apart, to dst in wire format. Each field is copied
+ * for all records at once with the strided copy kernels.
+ */
+void struct_copy_records(const struct_object_t *structure, unsigned char *dst, const void *src, size_t stride,
+                         size_t num);
+
+#endif
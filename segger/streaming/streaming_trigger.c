@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "streaming_trigger.h"
+#include "streaming_config.h"
+#include "streaming_endian.h"
+#include "streaming_os.h"
+#include "streaming_packet.h"
+#include <string.h>
+
+// trigger conditions are evaluated on blocks of samples converted to double
+#define TRIGGER_BLOCK_SIZE 64
+
+// guards the list of triggers and the requested configurations
+static streaming_mutex_t trigger_mutex;
+static trigger_t *triggers[STREAMING_MAX_TRIGGERS];
+static unsigned int trigger_counter = 0;
+
+bool trigger_supported(signal_data_type_e datatype)
+{
+	switch (datatype) {
+	case signal_type_int8:
+	case signal_type_uint8:
+	case signal_type_int16:
+	case signal_type_uint16:
+	case signal_type_int32:
+	case signal_type_uint32:
+	case signal_type_int64:
+	case signal_type_uint64:
+	case signal_type_real32:
+	case signal_type_real64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void triggers_init(void)
+{
+	streaming_mutex_init(&trigger_mutex);
+}
+
+static void trigger_reset(trigger_t *trigger)
+{
+	trigger->head = 0;
+	trigger->fill = 0;
+	trigger->remaining = 0;
+	trigger->prev_valid = false;
+	atomic_store(&trigger->fire_pending, false);
+}
+
+int streaming_trigger_add(trigger_t *trigger, signal_t *signal, void *ring, size_t ring_size,
+                          trigger_window_callback *on_window)
+{
+	signal_definition_t *def = signal->definition;
+
+	if (def->rule != signal_explicit_rule || !trigger_supported(def->datatype)) {
+		return -1;
+	}
+
+	streaming_mutex_lock(&trigger_mutex);
+	if (trigger_counter >= STREAMING_MAX_TRIGGERS) {
+		streaming_mutex_unlock(&trigger_mutex);
+		return -1;
+	}
+
+	trigger->signal = signal;
+	trigger->on_window = on_window;
+	trigger->mode = trigger_off;
+	trigger->level = 0;
+	trigger->pre = 0;
+	trigger->post = 1;
+	trigger->ring = ring;
+	trigger->capacity = ring_size / openDAQ_get_sample_size(def->datatype);
+	atomic_init(&trigger->reconfigure, false);
+	atomic_init(&trigger->fire_pending, false);
+	trigger_reset(trigger);
+	triggers[trigger_counter++] = trigger;
+	streaming_mutex_unlock(&trigger_mutex);
+	return 0;
+}
+
+trigger_t *triggers_find(const char *signalId)
+{
+	trigger_t *trigger = NULL;
+
+	streaming_mutex_lock(&trigger_mutex);
+	for (unsigned int i = 0; i < trigger_counter; i++) {
+		if (!strcmp(signalId, triggers[i]->signal->definition->name)) {
+			trigger = triggers[i];
+			break;
+		}
+	}
+	streaming_mutex_unlock(&trigger_mutex);
+	return trigger;
+}
+
+bool streaming_trigger_config_valid(const trigger_t *trigger, uint32_t pre, uint32_t post)
+{
+	return pre <= trigger->capacity && post > 0;
+}
+
+int streaming_trigger_configure(trigger_t *trigger, trigger_mode_e mode, double level, uint32_t pre, uint32_t post)
+{
+	if (!streaming_trigger_config_valid(trigger, pre, post)) {
+		return -1;
+	}
+
+	streaming_mutex_lock(&trigger_mutex);
+	trigger->requested.mode = mode;
+	trigger->requested.level = level;
+	trigger->requested.pre = pre;
+	trigger->requested.post = post;
+	atomic_store(&trigger->reconfigure, true);
+	streaming_mutex_unlock(&trigger_mutex);
+	return 0;
+}
+
+void streaming_trigger_fire(trigger_t *trigger)
+{
+	atomic_store(&trigger->fire_pending, true);
+}
+
+/**
+ * takes over a configuration requested by streaming_trigger_configure. The lock is only held for the copy,
+ * so serializing and the window callback do not block other tasks.
+ */
+static void trigger_apply_configuration(trigger_t *trigger)
+{
+	if (!atomic_load(&trigger->reconfigure)) {
+		return;
+	}
+
+	streaming_mutex_lock(&trigger_mutex);
+	trigger->mode = trigger->requested.mode;
+	trigger->level = trigger->requested.level;
+	trigger->pre = trigger->requested.pre;
+	trigger->post = trigger->requested.post;
+	atomic_store(&trigger->reconfigure, false);
+	streaming_mutex_unlock(&trigger_mutex);
+	trigger_reset(trigger);
+}
+
+/**
+ * appends samples to the pre-trigger ring, older samples are overwritten
+ */
+static void ring_push(trigger_t *trigger, const unsigned char *src, uint32_t num)
+{
+	size_t sample_size = openDAQ_get_sample_size(trigger->signal->definition->datatype);
+
+	if (trigger->capacity == 0) {
+		return;
+	}
+	if (num > trigger->capacity) {
+		src += (num - trigger->capacity) * sample_size;
+		num = trigger->capacity;
+	}
+
+	uint32_t first = trigger->capacity - trigger->head < num ? trigger->capacity - trigger->head : num;
+	memcpy(trigger->ring + trigger->head * sample_size, src, first * sample_size);
+	memcpy(trigger->ring, src + first * sample_size, (num - first) * sample_size);
+	trigger->head = (trigger->head + num) % trigger->capacity;
+	trigger->fill = trigger->fill + num < trigger->capacity ? trigger->fill + num : trigger->capacity;
+}
+
+/**
+ * serializes the last num samples of the pre-trigger ring as one packet
+ */
+static int serialize_history(trigger_t *trigger, unsigned char *dst, size_t dst_size, uint32_t num)
+{
+	size_t sample_size = openDAQ_get_sample_size(trigger->signal->definition->datatype);
+	uint32_t start = (trigger->head + trigger->capacity - num) % trigger->capacity;
+	uint32_t before_wrap = trigger->capacity - start < num ? trigger->capacity - start : num;
+
+	return openDAQ_streaming_serialize_explicit_signal_ring(dst, dst_size, trigger->signal,
+	                                                        trigger->ring + start * sample_size, before_wrap,
+	                                                        trigger->ring, num - before_wrap, 0);
+}
+
+/**
+ * signals the samples in front of index that were not transmitted as gap, the client would stamp the following
+ * samples right after the previously transmitted ones otherwise
+ */
+static int serialize_skipped(trigger_t *trigger, unsigned char *dst, size_t dst_size, uint64_t index)
+{
+	signal_t *signal = trigger->signal;
+	int written = 0;
+
+	if (!signal_has_subscription(signal) || index <= signal->sample_index) {
+		return 0;
+	}
+	// a gap counts at most UINT32_MAX samples, all of them are checked for room first
+	uint64_t gaps = (index - signal->sample_index + UINT32_MAX - 1) / UINT32_MAX;
+	if (openDAQ_streaming_gap_size(signal) * gaps > dst_size) {
+		return -1;
+	}
+	while (index > signal->sample_index) {
+		uint64_t skipped = index - signal->sample_index;
+		int ret = openDAQ_streaming_serialize_gap(dst + written, dst_size - written, signal,
+		                                          skipped < UINT32_MAX ? (uint32_t)skipped : UINT32_MAX);
+		if (ret < 0) {
+			return ret;
+		}
+		written += ret;
+	}
+	return written;
+}
+
+/**
+ * evaluates the trigger condition for num samples
+ *
+ * @return index of the first sample that fires, num if none fires
+ */
+static uint32_t find_trigger(trigger_t *trigger, const unsigned char *src, uint32_t num)
+{
+	signal_data_type_e datatype = trigger->signal->definition->datatype;
+	size_t sample_size = openDAQ_get_sample_size(datatype);
+	double block[TRIGGER_BLOCK_SIZE];
+	double level = trigger->level;
+
+	if (trigger->mode == trigger_external) {
+		if (num > 0 && atomic_exchange(&trigger->fire_pending, false)) {
+			return 0;
+		}
+		return num;
+	}
+
+	for (uint32_t done = 0; done < num;) {
+		uint32_t n = num - done < TRIGGER_BLOCK_SIZE ? num - done : TRIGGER_BLOCK_SIZE;
+		streaming_samples_to_double(datatype, block, src + done * sample_size, n);
+
+		for (uint32_t i = 0; i < n; i++) {
+			bool fire;
+			switch (trigger->mode) {
+			case trigger_level:
+				fire = block[i] >= level;
+				break;
+			case trigger_rising:
+				fire = trigger->prev_valid && trigger->prev < level && block[i] >= level;
+				break;
+			case trigger_falling:
+				fire = trigger->prev_valid && trigger->prev > level && block[i] <= level;
+				break;
+			default:
+				fire = false;
+				break;
+			}
+			trigger->prev = block[i];
+			trigger->prev_valid = true;
+			if (fire) {
+				return done + i;
+			}
+		}
+		done += n;
+	}
+	return num;
+}
+
+int streaming_trigger_process(trigger_t *trigger, void *dst, size_t dst_size, uint64_t index, const void *src,
+                              unsigned int num)
+{
+	size_t sample_size = openDAQ_get_sample_size(trigger->signal->definition->datatype);
+	const unsigned char *src_ptr = src;
+	unsigned char *dst_ptr = dst;
+	int ret = 0;
+
+	trigger_apply_configuration(trigger);
+
+	if (trigger->mode == trigger_off) {
+		// continuous streaming, behind a gap if windows were streamed before
+		int gap = serialize_skipped(trigger, dst_ptr, dst_size, index);
+		if (gap < 0) {
+			return gap;
+		}
+		ret = openDAQ_streaming_serialize_explicit_signal(dst_ptr + gap, dst_size - gap, trigger->signal, src, num);
+		// the gap is handed out even if the samples failed
+		return ret < 0 ? (gap > 0 ? gap : ret) : gap + ret;
+	}
+
+	for (uint32_t done = 0; done < num;) {
+		size_t space = dst_size - (dst_ptr - (unsigned char *)dst);
+
+		if (trigger->remaining > 0) {
+			// window open, pass the post-trigger samples through
+			uint32_t n = num - done < trigger->remaining ? num - done : trigger->remaining;
+			ret = openDAQ_streaming_serialize_explicit_signal(dst_ptr, space, trigger->signal,
+			                                                  src_ptr + done * sample_size, n);
+			if (ret < 0) {
+				break;
+			}
+			dst_ptr += ret;
+			done += n;
+			trigger->remaining -= n;
+			if (trigger->remaining == 0) {
+				// the history of the next window starts after this window
+				trigger->fill = 0;
+				trigger->prev_valid = false;
+			}
+			continue;
+		}
+
+		uint32_t n = find_trigger(trigger, src_ptr + done * sample_size, num - done);
+		ring_push(trigger, src_ptr + done * sample_size, n);
+		done += n;
+		if (done == num) {
+			break;
+		}
+
+		// fired, the window opens with the history
+		uint32_t history = trigger->fill < trigger->pre ? trigger->fill : trigger->pre;
+		ret = serialize_skipped(trigger, dst_ptr, space, index + done - history);
+		if (ret < 0) {
+			break;
+		}
+		dst_ptr += ret;
+		space -= ret;
+		if (trigger->on_window != NULL) {
+			ret = trigger->on_window(trigger, index + done - history, dst_ptr, space);
+			if (ret < 0) {
+				break;
+			}
+			dst_ptr += ret;
+			space -= ret;
+		}
+		if (history > 0) {
+			ret = serialize_history(trigger, dst_ptr, space, history);
+			if (ret < 0) {
+				break;
+			}
+			dst_ptr += ret;
+		}
+		trigger->fill = 0;
+		trigger->remaining = trigger->post;
+	}
+
+	size_t len = dst_ptr - (unsigned char *)dst;
+	// complete packets written before an error are handed out, the caller cannot undo them
+	return ret < 0 && len == 0 ? ret : (int)len;
+}
+
+const char *trigger_mode_to_string(trigger_mode_e mode)
+{
+	switch (mode) {
+	case trigger_off:
+		return "off";
+	case trigger_level:
+		return "level";
+	case trigger_rising:
+		return "rising";
+	case trigger_falling:
+		return "falling";
+	case trigger_external:
+		return "external";
+	}
+	return "unknown";
+}
+
+trigger_mode_e trigger_mode_from_string(const char *mode)
+{
+	if (!strcmp(mode, "level")) {
+		return trigger_level;
+	}
+	if (!strcmp(mode, "rising")) {
+		return trigger_rising;
+	}
+	if (!strcmp(mode, "falling")) {
+		return trigger_falling;
+	}
+	if (!strcmp(mode, "external")) {
+		return trigger_external;
+	}
+	return trigger_off;
+}
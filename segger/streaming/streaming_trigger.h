@@ -0,0 +1,160 @@
+#ifndef _STREAMING_TRIGGER_H_
+#define _STREAMING_TRIGGER_H_
+
+#include "streaming_signals.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * a trigger stage streams an explicit signal only in windows around events. While no window is open, the
+ * samples are kept in a bounded pre-trigger ring. When the trigger condition fires, the last pre samples of
+ * the ring and the following post samples, starting with the triggering sample, are serialized. Otherwise
+ * nothing is written. The samples between two windows are signalled as gap in front of the later window, so
+ * the client stamps every window at its index.
+ */
+
+typedef enum {
+	trigger_off,
+	// sample >= level
+	trigger_level,
+	// previous sample < level and sample >= level
+	trigger_rising,
+	// previous sample > level and sample <= level
+	trigger_falling,
+	// streaming_trigger_fire was called
+	trigger_external,
+} trigger_mode_e;
+
+typedef struct trigger_t trigger_t;
+
+/**
+ * called when a window opens, before its samples are serialized. The samples skipped since the previous window
+ * are already signalled as gap (openDAQ_streaming_serialize_gap), which gives the subscribed linear signals of
+ * the table a new start value, so the callback is only needed for additional packets, e.g. a status.
+ *
+ * @param trigger the trigger whose window opens
+ * @param index index of the first sample of the window
+ * @param dst destination buffer
+ * @param dst_size size in bytes of the destination buffer
+ *
+ * @return <0    error
+ *         else  number of bytes written
+ */
+typedef int trigger_window_callback(trigger_t *trigger, uint64_t index, void *dst, size_t dst_size);
+
+typedef struct {
+	trigger_mode_e mode;
+	double level;
+	uint32_t pre;
+	uint32_t post;
+} trigger_config_t;
+
+struct trigger_t {
+	signal_t *signal;
+	trigger_window_callback *on_window;
+	// configuration in use, only touched by streaming_trigger_process
+	trigger_mode_e mode;
+	double level;
+	uint32_t pre;
+	uint32_t post;
+	// configuration of streaming_trigger_configure, taken over by the next streaming_trigger_process
+	trigger_config_t requested;
+	atomic_bool reconfigure;
+	// pre-trigger ring, capacity samples of the signal
+	unsigned char *ring;
+	uint32_t capacity;
+	uint32_t head;
+	uint32_t fill;
+	// state
+	uint32_t remaining;
+	bool prev_valid;
+	double prev;
+	atomic_bool fire_pending;
+};
+
+/**
+ * whether signals of datatype can be triggered. Only integer types of up to 64 bit and real types are supported.
+ */
+bool trigger_supported(signal_data_type_e datatype);
+
+/**
+ * prepares the trigger module, called once by streaming_init
+ */
+void triggers_init(void);
+
+/**
+ * attaches a trigger stage to an explicit signal. The trigger starts in mode trigger_off, in which every sample
+ * is passed through. The trigger can be configured by the client through the JSON-RPC method
+ * "<streamId>.trigger".
+ *
+ * @param trigger the trigger to set up, must stay valid
+ * @param signal the explicit signal to trigger
+ * @param ring buffer for the pre-trigger ring
+ * @param ring_size size in bytes of ring, limits the pre-trigger window
+ * @param on_window called when a window opens, may be NULL
+ *
+ * @return <0 error, e.g. the signal cannot be triggered or too many triggers
+ *         0  success
+ */
+int streaming_trigger_add(trigger_t *trigger, signal_t *signal, void *ring, size_t ring_size,
+                          trigger_window_callback *on_window);
+
+/**
+ * @return the trigger attached to the signal with signalId, NULL if there is none
+ */
+trigger_t *triggers_find(const char *signalId);
+
+/**
+ * whether pre and post are a valid window of the trigger: pre at most the capacity of the ring, post at least 1
+ */
+bool streaming_trigger_config_valid(const trigger_t *trigger, uint32_t pre, uint32_t post);
+
+/**
+ * configures the trigger. The next streaming_trigger_process takes over the configuration and drops the
+ * history and an open window, so the configuration can be changed from any task.
+ *
+ * @param trigger the trigger to configure
+ * @param mode trigger condition
+ * @param level threshold of level and edge triggers
+ * @param pre number of samples before the triggering sample, at most the capacity of the ring
+ * @param post number of samples from the triggering sample on, at least 1
+ *
+ * @return <0 invalid configuration
+ *         0  success
+ */
+int streaming_trigger_configure(trigger_t *trigger, trigger_mode_e mode, double level, uint32_t pre, uint32_t post);
+
+/**
+ * fires an external trigger with the next processed sample, can be called from any task
+ */
+void streaming_trigger_fire(trigger_t *trigger);
+
+/**
+ * feeds samples through the trigger stage and serializes the windows. Only one task may process the samples
+ * of a trigger, the window callback is called from this task.
+ *
+ * @param trigger the trigger
+ * @param dst pointer to destination buffer
+ * @param dst_size size in bytes of destination buffer
+ * @param index index of the first sample at src, the samples not transmitted in front of it are signalled as gap
+ * @param src contiguous samples of the signal
+ * @param num number of samples at src
+ *
+ * @return <0    error, e.g. destination buffer too small, nothing was written
+ *         0     no window open, nothing written
+ *         else  number of bytes written. If a later packet failed, the packets written before are complete
+ *               and the samples from the failing packet on are dropped.
+ */
+int streaming_trigger_process(trigger_t *trigger, void *dst, size_t dst_size, uint64_t index, const void *src,
+                              unsigned int num);
+
+const char *trigger_mode_to_string(trigger_mode_e mode);
+
+/**
+ * @return trigger_off if the string is not a known mode
+ */
+trigger_mode_e trigger_mode_from_string(const char *mode);
+
+#endif
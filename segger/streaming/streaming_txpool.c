@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2023 openDAQ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "streaming_txpool.h"
+#include "streaming_congestion.h"
+#include <string.h>
+
+static void release_locked(txpool_t *pool, txbuf_t *buf)
+{
+	buf->next = pool->free;
+	pool->free = buf;
+	pool->stats.blocks_in_use--;
+}
+
+/**
+ * calls the completion callback without holding the lock, so it may allocate and submit again
+ */
+static void complete_buffer(txpool_t *pool, txbuf_t *buf, txbuf_status_e status)
+{
+	txbuf_complete_callback *callback = buf->complete;
+	void *context = buf->context;
+
+	if (callback != NULL) {
+		callback(buf, status, context);
+	}
+
+	streaming_mutex_lock(&pool->mutex);
+	switch (status) {
+	case txbuf_sent:
+		pool->stats.sent++;
+		break;
+	case txbuf_failed:
+		pool->stats.failed++;
+		break;
+	case txbuf_dropped:
+		pool->stats.dropped++;
+		break;
+	}
+	if (buf->pooled) {
+		release_locked(pool, buf);
+	}
+	streaming_mutex_unlock(&pool->mutex);
+}
+
+int streaming_txpool_init(txpool_t *pool, const struct stream *stream, void *memory, size_t memory_size,
+                          size_t block_size)
+{
+	if (block_size == 0 || memory_size < block_size) {
+		return -1;
+	}
+
+	size_t blocks = memory_size / block_size;
+	if (blocks > STREAMING_TXPOOL_BLOCKS) {
+		blocks = STREAMING_TXPOOL_BLOCKS;
+	}
+
+	memset(pool, 0, sizeof(*pool));
+	for (size_t i = blocks; i-- > 0;) {
+		txbuf_t *buf = &pool->bufs[i];
+		buf->data = (unsigned char *)memory + i * block_size;
+		buf->capacity = block_size;
+		buf->pooled = true;
+		buf->next = pool->free;
+		pool->free = buf;
+	}
+	pool->stream = stream;
+	pool->connected = stream != NULL;
+	pool->running = true;
+	pool->stats.blocks = (uint32_t)blocks;
+	pool->stats.block_size = block_size;
+	streaming_mutex_init(&pool->mutex);
+	streaming_wakeup_init(&pool->wakeup);
+	streaming_wakeup_init(&pool->idle);
+	return (int)blocks;
+}
+
+txbuf_t *streaming_txpool_alloc(txpool_t *pool)
+{
+	streaming_mutex_lock(&pool->mutex);
+	txbuf_t *buf = pool->free;
+	if (buf == NULL) {
+		pool->stats.alloc_failures++;
+	} else {
+		pool->free = buf->next;
+		buf->next = NULL;
+		buf->length = 0;
+		pool->stats.blocks_in_use++;
+		if (pool->stats.blocks_in_use > pool->stats.blocks_high_watermark) {
+			pool->stats.blocks_high_watermark = pool->stats.blocks_in_use;
+		}
+	}
+	streaming_mutex_unlock(&pool->mutex);
+	return buf;
+}
+
+void streaming_txpool_free(txpool_t *pool, txbuf_t *buf)
+{
+	if (!buf->pooled) {
+		// wrapped memory belongs to the caller
+		return;
+	}
+	streaming_mutex_lock(&pool->mutex);
+	release_locked(pool, buf);
+	streaming_mutex_unlock(&pool->mutex);
+}
+
+void streaming_txbuf_wrap(txbuf_t *buf, const void *data, size_t length)
+{
+	memset(buf, 0, sizeof(*buf));
+	// only read by the pool
+	buf->data = (unsigned char *)data;
+	buf->capacity = length;
+	buf->length = length;
+}
+
+int streaming_txpool_submit(txpool_t *pool, txbuf_t *buf, size_t length, txbuf_complete_callback *complete,
+                            void *context)
+{
+	if (length > buf->capacity) {
+		return -1;
+	}
+
+	buf->length = length;
+	buf->complete = complete;
+	buf->context = context;
+	buf->next = NULL;
+
+	streaming_mutex_lock(&pool->mutex);
+	if (!pool->connected) {
+		streaming_mutex_unlock(&pool->mutex);
+		complete_buffer(pool, buf, txbuf_dropped);
+		return 0;
+	}
+	if (pool->tail == NULL) {
+		pool->head = buf;
+	} else {
+		pool->tail->next = buf;
+	}
+	pool->tail = buf;
+	pool->stats.queued++;
+	if (pool->stats.queued > pool->stats.queued_high_watermark) {
+		pool->stats.queued_high_watermark = pool->stats.queued;
+	}
+	streaming_mutex_unlock(&pool->mutex);
+	streaming_wakeup_signal(&pool->wakeup);
+	return 0;
+}
+
+int streaming_txpool_poll(txpool_t *pool)
+{
+	streaming_mutex_lock(&pool->mutex);
+	txbuf_t *buf = pool->head;
+	if (buf == NULL) {
+		streaming_mutex_unlock(&pool->mutex);
+		return 0;
+	}
+	pool->head = buf->next;
+	if (pool->head == NULL) {
+		pool->tail = NULL;
+	}
+	pool->stats.queued--;
+	pool->sending = buf;
+	const struct stream *stream = pool->stream;
+	streaming_mutex_unlock(&pool->mutex);
+
+	// the bytes of a buffer must not be interleaved with those of other writers of the stream
+	if (stream->lock != NULL) {
+		streaming_mutex_lock(&stream->lock->mutex);
+	}
+	int ret = stream->stream(stream, (const char *)buf->data, buf->length);
+	if (stream->lock != NULL) {
+		streaming_mutex_unlock(&stream->lock->mutex);
+	}
+	// a packet may continue in the next buffer, so the fill level is not sent here but by the next writer
+	streaming_congestion_recalculate(stream);
+
+	size_t length = buf->length;
+	complete_buffer(pool, buf, ret < 0 ? txbuf_failed : txbuf_sent);
+
+	streaming_mutex_lock(&pool->mutex);
+	pool->sending = NULL;
+	streaming_mutex_unlock(&pool->mutex);
+	streaming_wakeup_signal(&pool->idle);
+	return ret < 0 ? ret : (int)length;
+}
+
+void streaming_txpool_run(txpool_t *pool)
+{
+	while (pool->running) {
+		if (streaming_txpool_poll(pool) == 0) {
+			streaming_wakeup_wait(&pool->wakeup, STREAMING_WAIT_FOREVER);
+		}
+	}
+}
+
+void streaming_txpool_stop(txpool_t *pool)
+{
+	pool->running = false;
+	streaming_wakeup_signal(&pool->wakeup);
+}
+
+void streaming_txpool_connect(txpool_t *pool, const struct stream *stream)
+{
+	streaming_mutex_lock(&pool->mutex);
+	pool->stream = stream;
+	pool->connected = true;
+	streaming_mutex_unlock(&pool->mutex);
+}
+
+void streaming_txpool_disconnect(txpool_t *pool)
+{
+	streaming_mutex_lock(&pool->mutex);
+	txbuf_t *buf = pool->head;
+	pool->head = NULL;
+	pool->tail = NULL;
+	pool->stats.queued = 0;
+	pool->connected = false;
+	streaming_mutex_unlock(&pool->mutex);
+
+	while (buf != NULL) {
+		txbuf_t *next = buf->next;
+		complete_buffer(pool, buf, txbuf_dropped);
+		buf = next;
+	}
+
+	// a buffer the transmit task is sending right now still uses the stream and is completed by it
+	streaming_mutex_lock(&pool->mutex);
+	while (pool->sending != NULL) {
+		streaming_mutex_unlock(&pool->mutex);
+		streaming_wakeup_wait(&pool->idle, STREAMING_WAIT_FOREVER);
+		streaming_mutex_lock(&pool->mutex);
+	}
+	streaming_mutex_unlock(&pool->mutex);
+}
+
+void streaming_txpool_stats(txpool_t *pool, txpool_stats_t *stats)
+{
+	streaming_mutex_lock(&pool->mutex);
+	*stats = pool->stats;
+	streaming_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,165 @@
+#ifndef _STREAMING_TXPOOL_H_
+#define _STREAMING_TXPOOL_H_
+
+#include "stream_id.h"
+#include "streaming_config.h"
+#include "streaming_os.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * a transmit pool owns fixed size blocks for outgoing data and a queue of submitted buffers. Producers fill a
+ * block (or wrap memory of their own, e.g. an acquisition buffer) and submit it, the transmit task running
+ * streaming_txpool_run writes the buffers to the stream in order. Every submitted buffer is completed exactly
+ * once through its callback:
+ *  - txbuf_sent:    the stream took all bytes, the memory may be reused
+ *  - txbuf_failed:  the stream returned an error
+ *  - txbuf_dropped: the connection went away before the buffer was sent
+ * Pool blocks return to the pool after the callback. The RAM footprint is fixed by the memory passed to
+ * streaming_txpool_init, the high-watermarks show how much of it is needed.
+ */
+
+typedef enum {
+	txbuf_sent,
+	txbuf_failed,
+	txbuf_dropped,
+} txbuf_status_e;
+
+struct txbuf;
+
+/**
+ * called by the transmit task, or by the task calling streaming_txpool_disconnect, once per submitted buffer.
+ * Must not block.
+ */
+typedef void txbuf_complete_callback(struct txbuf *buf, txbuf_status_e status, void *context);
+
+typedef struct txbuf {
+	unsigned char *data;
+	// bytes data can hold
+	size_t capacity;
+	// bytes to send, set by streaming_txpool_submit
+	size_t length;
+	txbuf_complete_callback *complete;
+	void *context;
+	struct txbuf *next;
+	// block of the pool, false for buffers wrapping memory of the caller
+	bool pooled;
+} txbuf_t;
+
+typedef struct {
+	uint32_t blocks;
+	size_t block_size;
+	uint32_t blocks_in_use;
+	uint32_t blocks_high_watermark;
+	// submitted buffers waiting for the transmit task, pooled or not
+	uint32_t queued;
+	uint32_t queued_high_watermark;
+	uint32_t alloc_failures;
+	uint32_t sent;
+	uint32_t failed;
+	uint32_t dropped;
+} txpool_stats_t;
+
+typedef struct {
+	const struct stream *stream;
+	txbuf_t bufs[STREAMING_TXPOOL_BLOCKS];
+	txbuf_t *free;
+	txbuf_t *head;
+	txbuf_t *tail;
+	// buffer the transmit task is sending, NULL if none
+	txbuf_t *sending;
+	bool connected;
+	bool running;
+	streaming_mutex_t mutex;
+	streaming_wakeup_t wakeup;
+	// signalled whenever the transmit task completed a buffer
+	streaming_wakeup_t idle;
+	txpool_stats_t stats;
+} txpool_t;
+
+/**
+ * sets up a transmit pool, memory is split into blocks of block_size bytes, at most STREAMING_TXPOOL_BLOCKS
+ *
+ * @param pool the pool to set up, must stay valid
+ * @param stream the stream the buffers are sent through, NULL until streaming_txpool_connect
+ * @param memory memory of the blocks
+ * @param memory_size size in bytes of memory
+ * @param block_size size in bytes of one block
+ *
+ * @return <0 error, e.g. memory smaller than one block
+ *         else number of blocks
+ */
+int streaming_txpool_init(txpool_t *pool, const struct stream *stream, void *memory, size_t memory_size,
+                          size_t block_size);
+
+/**
+ * takes a free block of the pool, never blocks
+ *
+ * @return NULL if all blocks are in use
+ */
+txbuf_t *streaming_txpool_alloc(txpool_t *pool);
+
+/**
+ * returns a block that was not submitted to the pool, wrapped buffers are ignored
+ */
+void streaming_txpool_free(txpool_t *pool, txbuf_t *buf);
+
+/**
+ * lets buf refer to memory of the caller, which is sent without copying it into a block. The memory and buf
+ * must stay valid until the buffer is completed.
+ */
+void streaming_txbuf_wrap(txbuf_t *buf, const void *data, size_t length);
+
+/**
+ * queues a buffer for transmission
+ *
+ * @param pool the pool
+ * @param buf a block of the pool or a wrapped buffer
+ * @param length bytes of buf to send, at most its capacity
+ * @param complete called when the buffer is done with, may be NULL
+ * @param context passed to complete
+ *
+ * @return <0 error, length exceeds the capacity. The buffer is not queued and not completed.
+ *         0  success, the buffer is completed later. Without a connection it is completed as dropped before
+ *            this function returns.
+ */
+int streaming_txpool_submit(txpool_t *pool, txbuf_t *buf, size_t length, txbuf_complete_callback *complete,
+                            void *context);
+
+/**
+ * sends the oldest queued buffer and completes it, called by the transmit task. The buffer is written under the
+ * lock of the stream. The fill level is recalculated afterwards but not sent, a packet may continue in the next
+ * buffer.
+ *
+ * @return <0    error of the stream, the buffer is completed as failed
+ *         0     nothing queued
+ *         else  number of bytes sent
+ */
+int streaming_txpool_poll(txpool_t *pool);
+
+/**
+ * body of the transmit task, sends buffers until streaming_txpool_stop
+ */
+void streaming_txpool_run(txpool_t *pool);
+void streaming_txpool_stop(txpool_t *pool);
+
+/**
+ * attaches the pool to the stream of a new connection
+ */
+void streaming_txpool_connect(txpool_t *pool, const struct stream *stream);
+
+/**
+ * detaches the pool from its stream, e.g. from the on_disconnect callback. All queued buffers are completed as
+ * dropped, buffers submitted until the next streaming_txpool_connect as well. A buffer the transmit task is
+ * sending is waited for, so the stream is not used anymore when this function returns. Must not be called by the
+ * transmit task.
+ */
+void streaming_txpool_disconnect(txpool_t *pool);
+
+/**
+ * copies usage, high-watermarks and completion counters
+ */
+void streaming_txpool_stats(txpool_t *pool, txpool_stats_t *stats);
+
+#endif